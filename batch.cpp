@@ -0,0 +1,268 @@
+#include "batch.h"
+#include "polygonfile.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Boolean2D {
+
+static bool parseOperation(const QString& name, Operation& op) {
+    const QString n = name.toLower();
+    if (n == "union" || n == "addition") { op = Operation::Addition;     return true; }
+    if (n == "intersection")             { op = Operation::Intersection; return true; }
+    if (n == "a-b" || n == "subab")      { op = Operation::SubAB;        return true; }
+    if (n == "b-a" || n == "subba")      { op = Operation::SubBA;        return true; }
+    return false;
+}
+
+static const char* operationName(Operation op) {
+    switch (op) {
+    case Operation::Addition:     return "union";
+    case Operation::Intersection: return "intersection";
+    case Operation::SubAB:        return "a-b";
+    case Operation::SubBA:        return "b-a";
+    }
+    return "";
+}
+
+bool readManifest(const QString& filePath, QVector<BatchJob>& jobs, QString* error) {
+    jobs.clear();
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
+                         ).arg(filePath, file.errorString());
+        }
+        return false;
+    }
+    const QDir base = QFileInfo(filePath).absoluteDir();
+    QTextStream in(&file);
+    int lineCount = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineCount;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        QStringList cols;
+        if (line.contains('\t')) {
+            for (const QString& c : line.split('\t', Qt::SkipEmptyParts)) cols.push_back(c.trimmed());
+        } else {
+            cols = line.simplified().split(' ');
+        }
+        BatchJob job;
+        if (cols.size() != 4 || !parseOperation(cols[2], job.op)) {
+            if (error) *error = QStringLiteral("ERROR: WRONG FORMAT AT LINE %1.").arg(lineCount);
+            jobs.clear();
+            return false;
+        }
+        job.fileA = base.absoluteFilePath(cols[0]);
+        job.fileB = base.absoluteFilePath(cols[1]);
+        job.out   = base.absoluteFilePath(cols[3]);
+        job.line  = lineCount;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+QString BatchSummary::summary() const {
+    auto ms = [](double v) { return QString::number(v, 'f', 2); };
+    return QString("jobs %1, failed %2, wall %3 s, %4 jobs/s | latency ms: p50 %5, p90 %6, p99 %7, max %8")
+        .arg(jobs).arg(failed).arg(QString::number(wallNs / 1e9, 'f', 3)).arg(QString::number(jobsPerSec, 'f', 1))
+        .arg(ms(p50Ms), ms(p90Ms), ms(p99Ms), ms(maxMs));
+}
+
+// job indices of one worker; the owner takes from the front, thieves from the back
+struct StealQueue {
+    std::mutex      mutex;
+    std::deque<int> jobs;
+
+    bool pop(int& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+    bool steal(int& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+};
+
+// what a worker keeps between jobs
+struct BatchWorker {
+    Engine       engine;
+    QVector<Geometry::AtomicSegment> atoms;
+    Geometry::PolygonTopo topoA;
+    Geometry::PolygonTopo topoB;
+    QString      pathA; // file topoA/topoB hold, empty after a failed load
+    QString      pathB;
+    InputPolygon text; // text inputs are parsed here first
+    QVector<qint64> latencyNs;
+    int          failed = 0;
+};
+
+// binary files go from the mapping straight into topo, text files through an InputPolygon
+static bool loadCached(const QString& path, Geometry::PolygonTopo& topo, QString& loadedPath, InputPolygon& text,
+                       QString* error) {
+    if (path == loadedPath) return true;
+    loadedPath.clear();
+    if (PolygonFileView::isBinaryFile(path)) {
+        PolygonFileView view;
+        if (!view.open(path, error)) return false;
+        if (view.loopCount() == 0 || view.loop(0).count == 0) {
+            if (error) {
+                *error = QStringLiteral(
+                             "ERROR: NO OUTER LOOP FOUND IN FILE %1."
+                             ).arg(path);
+            }
+            return false;
+        }
+        view.toTopo(topo);
+    } else {
+        if (!text.loadData(path, error)) return false;
+        makeTopoFromInput(text, topo);
+    }
+    loadedPath = path;
+    return true;
+}
+
+// one job on the worker's engine; the output is written before returning
+static bool runJob(const BatchJob& job, const BatchOptions& opts, const Geometry::AtomizeOptions& atomize,
+                   BatchWorker& w, int& polygons, QString* error) {
+    if (!loadCached(job.fileA, w.topoA, w.pathA, w.text, error) || !loadCached(job.fileB, w.topoB, w.pathB, w.text, error)) {
+        return false;
+    }
+    w.engine.run(job.op, w.topoA, w.topoB, w.atoms, opts.epsGeom, opts.epsParam, atomize);
+    const QVector<QVector<QPointF>> segments = segmentsToPolylines(w.atoms);
+    QDir().mkpath(QFileInfo(job.out).absolutePath());
+    if (opts.segments) {
+        polygons = segments.size();
+        return InputPolygon::savePolylines(job.out, segments, error);
+    }
+    const QVector<InputPolygon> result = stitchSegments(segments, opts.epsGeom);
+    polygons = result.size();
+    return InputPolygon::saveAll(job.out, result, error);
+}
+
+// RFC 4180: every field quoted, quotes inside doubled
+static QString csvField(const QString& value) {
+    QString quoted = value;
+    quoted.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + quoted + QLatin1Char('"');
+}
+
+static QByteArray csvRow(const QStringList& fields) {
+    QStringList quoted;
+    quoted.reserve(fields.size());
+    for (const QString& f : fields) quoted.push_back(csvField(f));
+    return (quoted.join(QLatin1Char(',')) + QLatin1Char('\n')).toUtf8();
+}
+
+// nearest rank on sorted values
+static double percentileMs(const QVector<qint64>& sortedNs, double p) {
+    if (sortedNs.isEmpty()) return 0.0;
+    const int rank = qBound(1, int(std::ceil(p * sortedNs.size())), int(sortedNs.size()));
+    return sortedNs[rank - 1] / 1e6;
+}
+
+BatchSummary runBatch(const QVector<BatchJob>& jobs, const BatchOptions& opts) {
+    BatchSummary summary;
+    summary.jobs = jobs.size();
+    int workerCount = opts.workers > 0 ? opts.workers : qMax(1, int(std::thread::hardware_concurrency()));
+    workerCount = qBound(1, workerCount, qMax(1, int(jobs.size())));
+    Geometry::AtomizeOptions atomize = opts.atomize;
+    atomize.threads = 1;
+
+    QFile report;
+    std::mutex reportMutex;
+    if (!opts.reportPath.isEmpty()) {
+        report.setFileName(opts.reportPath);
+        if (report.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+            report.write(csvRow({ "line", "fileA", "fileB", "op", "out", "ok", "ms", "polygons" }));
+        } else {
+            qWarning().noquote() << "[batch] no report:" << report.errorString();
+        }
+    }
+
+    // contiguous blocks, so jobs that share an input stay on one worker
+    std::vector<StealQueue> queues(workerCount);
+    for (int w = 0; w < workerCount; ++w) {
+        const int first = int(qint64(jobs.size()) * w / workerCount);
+        const int last  = int(qint64(jobs.size()) * (w + 1) / workerCount);
+        for (int k = first; k < last; ++k) queues[w].jobs.push_back(k);
+    }
+    std::vector<BatchWorker> workers(workerCount);
+    for (int w = 0; w < workerCount; ++w) workers[w].latencyNs.reserve(int(queues[w].jobs.size()));
+
+    auto work = [&](int self) {
+        BatchWorker& w = workers[self];
+        if (opts.propagate) w.engine.setClassifyMode(ClassifyMode::Propagate);
+        for (;;) {
+            int k = -1;
+            if (!queues[self].pop(k)) {
+                // nothing is queued after the start, so all queues empty means done
+                for (int v = 1; v < workerCount && k < 0; ++v) queues[(self + v) % workerCount].steal(k);
+                if (k < 0) return;
+            }
+            const BatchJob& job = jobs[k];
+            QElapsedTimer timer;
+            timer.start();
+            QString err;
+            int polygons = 0;
+            const bool ok = runJob(job, opts, atomize, w, polygons, &err);
+            const qint64 ns = timer.nsecsElapsed();
+            w.latencyNs.push_back(ns);
+            if (!ok) {
+                ++w.failed;
+                qWarning().noquote() << "[batch] line" << job.line << err;
+            }
+            if (report.isOpen()) {
+                const QByteArray row = csvRow({ QString::number(job.line), job.fileA, job.fileB,
+                                                QString::fromLatin1(operationName(job.op)), job.out,
+                                                QString::number(ok ? 1 : 0), QString::number(ns / 1e6, 'f', 3),
+                                                QString::number(polygons) });
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.write(row);
+            }
+        }
+    };
+
+    QElapsedTimer wall;
+    wall.start();
+    std::vector<std::thread> pool;
+    pool.reserve(workerCount - 1);
+    for (int w = 1; w < workerCount; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (auto& th : pool) th.join();
+    summary.wallNs = wall.nsecsElapsed();
+
+    QVector<qint64> latencies;
+    latencies.reserve(jobs.size());
+    for (const auto& w : workers) {
+        latencies += w.latencyNs;
+        summary.failed += w.failed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    summary.p50Ms = percentileMs(latencies, 0.50);
+    summary.p90Ms = percentileMs(latencies, 0.90);
+    summary.p99Ms = percentileMs(latencies, 0.99);
+    summary.maxMs = latencies.isEmpty() ? 0.0 : latencies.last() / 1e6;
+    summary.jobsPerSec = summary.wallNs > 0 ? jobs.size() * 1e9 / summary.wallNs : 0.0;
+    return summary;
+}
+
+}
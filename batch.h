@@ -0,0 +1,58 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "booleanops.h"
+
+namespace Boolean2D {
+
+// one row of a batch manifest
+struct BatchJob {
+    QString   fileA;
+    QString   fileB;
+    Operation op = Operation::Addition;
+    QString   out;
+    int       line = 0; // in the manifest, for messages
+};
+
+// Manifest: one job per line, "fileA fileB op out" separated by whitespace,
+// or by tabs when the line has any (paths with spaces). op is union |
+// addition | intersection | a-b | b-a. Blank lines and lines starting with
+// '#' are skipped; relative paths are taken from the manifest's directory.
+bool readManifest(const QString& filePath, QVector<BatchJob>& jobs, QString* error = nullptr);
+
+struct BatchOptions {
+    int    workers  = 0; // 0 = all cores
+    double epsGeom  = 1e-3;
+    double epsParam = 1e-9;
+    Geometry::AtomizeOptions atomize; // threads is forced to 1, the jobs run in parallel instead
+    bool    propagate = false; // ClassifyMode::Propagate
+    bool    segments  = false; // write the kept segments as "#polyline" blocks instead of stitched rings
+    QString reportPath; // CSV row per finished job, every field quoted; empty for none
+};
+
+struct BatchSummary {
+    int    jobs    = 0;
+    int    failed  = 0;
+    qint64 wallNs  = 0;
+    double jobsPerSec = 0.0;
+    // per-job latency: load, operation and write, milliseconds
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+
+    QString summary() const;
+};
+
+// Runs the jobs on a pool of worker threads. Each worker starts on a
+// contiguous block of the manifest and steals from the tail of another
+// worker's block once its own is done. A worker keeps one Engine and the
+// topologies of its inputs, so consecutive jobs reuse the buffers, and a file
+// that the previous job already loaded is not read again. Binary inputs are
+// read from the mapped file straight into the topology. Results are written
+// as each job finishes; a failed job is logged and counted, the rest still
+// run.
+BatchSummary runBatch(const QVector<BatchJob>& jobs, const BatchOptions& opts);
+
+}
@@ -0,0 +1,327 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QDebug>
+#include <cmath>
+#include <functional>
+#include <numbers>
+#include <random>
+#include "inputpolygon.h"
+#include "geometrymodel.h"
+#include "booleanops.h"
+
+// Times every pipeline stage on synthetic inputs and writes the results in
+// the JSON layout of Google Benchmark, so runs of two builds can be compared
+// with its compare.py or a plain diff.
+
+struct BenchCase {
+    QString      name;
+    InputPolygon polyA;
+    InputPolygon polyB;
+};
+
+struct BenchResult {
+    QString name;
+    qint64  iterations = 0;
+    double  realTimeNs = 0.0;
+};
+
+static QVector<QPointF> circleLoop(int n, double cx, double cy, double r) {
+    QVector<QPointF> pts;
+    pts.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        const double a = 2.0 * std::numbers::pi * i / n;
+        pts.push_back(QPointF(cx + r * std::cos(a), cy + r * std::sin(a)));
+    }
+    return pts;
+}
+
+static QVector<QPointF> rectLoop(double x0, double y0, double x1, double y1, bool clockwise) {
+    if (clockwise) {
+        return {QPointF(x0, y0), QPointF(x0, y1), QPointF(x1, y1), QPointF(x1, y0)};
+    }
+    return {QPointF(x0, y0), QPointF(x1, y0), QPointF(x1, y1), QPointF(x0, y1)};
+}
+
+// random star polygons, the spike depth shrinks with n so the number of
+// crossings with B stays linear
+static BenchCase makeStar(int n, std::mt19937& rng) {
+    std::uniform_real_distribution<double> radius(100.0 - qMin(60.0, 2000.0 / n), 100.0);
+    auto star = [&](double cx, double cy) {
+        QVector<QPointF> pts;
+        pts.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            const double a = 2.0 * std::numbers::pi * i / n;
+            const double r = radius(rng);
+            pts.push_back(QPointF(cx + r * std::cos(a), cy + r * std::sin(a)));
+        }
+        return pts;
+    };
+    BenchCase c;
+    c.name = QString("star/%1").arg(n);
+    c.polyA.setLoops(star(0.0, 0.0), {});
+    c.polyB.setLoops(star(15.0, 10.0), {});
+    return c;
+}
+
+// square with a k x k grid of square holes, B is the same grid shifted by half a cell
+static BenchCase makeHoles(int n, std::mt19937&) {
+    const int k = qMax(1, int(std::sqrt(n / 4.0)));
+    const double cell = 10.0;
+    auto grid = [&](double off, InputPolygon& poly) {
+        QVector<QVector<QPointF>> holes;
+        holes.reserve(k * k);
+        for (int i = 0; i < k; ++i) {
+            for (int j = 0; j < k; ++j) {
+                const double x = off + i * cell + 2.0;
+                const double y = off + j * cell + 2.0;
+                holes.push_back(rectLoop(x, y, x + 6.0, y + 6.0, true));
+            }
+        }
+        poly.setLoops(rectLoop(off, off, off + k * cell, off + k * cell, false), holes);
+    };
+    BenchCase c;
+    c.name = QString("holes/%1").arg(n);
+    grid(0.0, c.polyA);
+    grid(cell * 0.5, c.polyB);
+    return c;
+}
+
+// A's top edge is a sawtooth of tiny amplitude lying almost on B's bottom
+// edge, teeth of unit length so the tolerance boxes stay local
+static BenchCase makeSawtooth(int n, std::mt19937& rng) {
+    std::uniform_real_distribution<double> jitter(-1e-7, 1e-7);
+    const int teeth = qMax(2, n - 2);
+    const double width = teeth - 1;
+    QVector<QPointF> a;
+    a.reserve(teeth + 2);
+    a.push_back(QPointF(0.0, -10.0));
+    a.push_back(QPointF(width, -10.0));
+    for (int i = 0; i < teeth; ++i) {
+        const double x = width - i;
+        const double y = ((i & 1) ? 1e-5 : -1e-5) + jitter(rng);
+        a.push_back(QPointF(x, y));
+    }
+    BenchCase c;
+    c.name = QString("sawtooth/%1").arg(n);
+    c.polyA.setLoops(a, {});
+    c.polyB.setLoops(rectLoop(-5.0, 0.0, width + 5.0, 10.0, false), {});
+    return c;
+}
+
+// one huge fine circle against a unit square across its boundary
+static BenchCase makeHugeTiny(int n, std::mt19937&) {
+    const double r = 1e4;
+    BenchCase c;
+    c.name = QString("hugetiny/%1").arg(n);
+    c.polyA.setLoops(circleLoop(n, 0.0, 0.0, r), {});
+    c.polyB.setLoops(rectLoop(r - 0.5, -0.5, r + 0.5, 0.5, false), {});
+    return c;
+}
+
+// Repeats run until minSeconds of timed work has accumulated. setup runs
+// before every iteration outside the timed region.
+static BenchResult timeStage(const QString& name, double minSeconds,
+                             const std::function<void()>& setup, const std::function<void()>& run) {
+    const qint64 minNs = qint64(minSeconds * 1e9);
+    QElapsedTimer timer;
+    BenchResult res;
+    res.name = name;
+    qint64 totalNs = 0;
+    while (res.iterations == 0 || totalNs < minNs) {
+        setup();
+        timer.start();
+        run();
+        totalNs += timer.nsecsElapsed();
+        ++res.iterations;
+    }
+    res.realTimeNs = double(totalNs) / res.iterations;
+    return res;
+}
+
+static bool parseMode(const QString& name, Geometry::IntersectMode& mode) {
+    const QString n = name.toLower();
+    if (n == "brute") { mode = Geometry::IntersectMode::BruteForce; return true; }
+    if (n == "sweep") { mode = Geometry::IntersectMode::SweepLine;  return true; }
+    if (n == "grid")  { mode = Geometry::IntersectMode::GridIndex;  return true; }
+    if (n == "rtree") { mode = Geometry::IntersectMode::RTreeIndex; return true; }
+    return false;
+}
+
+// results the timed bodies fold into, so the optimizer cannot drop them
+static volatile qsizetype benchSink = 0;
+
+static void benchCase(const BenchCase& c, const Geometry::AtomizeOptions& opts, double minSeconds,
+                      QVector<BenchResult>& results) {
+    const double epsGeom  = 1e-3;
+    const double epsParam = 1e-9;
+    const Geometry::PolygonTopo topoA = Boolean2D::makeTopoFromInput(c.polyA);
+    const Geometry::PolygonTopo topoB = Boolean2D::makeTopoFromInput(c.polyB);
+    auto noSetup = [] {};
+    qsizetype sink = 0;
+
+    QVector<Geometry::RawEdge> rawA, rawB;
+    results.push_back(timeStage(c.name + "/buildRawEdges", minSeconds, noSetup, [&] {
+        rawA = Geometry::buildRawEdges(topoA, true);
+        rawB = Geometry::buildRawEdges(topoB, false);
+    }));
+
+    Geometry::EdgeWork workA, workB;
+    results.push_back(timeStage(c.name + "/injectSelfCollinearCuts", minSeconds, [&] {
+        workA = Geometry::initEdgeWork(rawA);
+        workB = Geometry::initEdgeWork(rawB);
+    }, [&] {
+        Geometry::injectSelfCollinearCuts(topoA, rawA, workA, epsGeom, epsParam);
+        Geometry::injectSelfCollinearCuts(topoB, rawB, workB, epsGeom, epsParam);
+    }));
+
+    // rebuilt from scratch so no cut list is shared with a previous iteration
+    results.push_back(timeStage(c.name + "/intersect", minSeconds, [&] {
+        workA = Geometry::initEdgeWork(rawA);
+        workB = Geometry::initEdgeWork(rawB);
+        Geometry::injectSelfCollinearCuts(topoA, rawA, workA, epsGeom, epsParam);
+        Geometry::injectSelfCollinearCuts(topoB, rawB, workB, epsGeom, epsParam);
+    }, [&] {
+        Geometry::intersectEdgeWork(topoA, rawA, workA, topoB, rawB, workB, epsGeom, epsParam, opts);
+    }));
+
+    QVector<Geometry::AtomicSegment> atoms;
+    results.push_back(timeStage(c.name + "/explodeEdgeWork", minSeconds, [&] {
+        atoms = QVector<Geometry::AtomicSegment>();
+    }, [&] {
+        Geometry::explodeEdgeWork(topoA, workA, epsParam, atoms);
+        Geometry::explodeEdgeWork(topoB, workB, epsParam, atoms);
+    }));
+
+    Boolean2D::PrepContext ctx;
+    results.push_back(timeStage(c.name + "/prepare", minSeconds, noSetup, [&] {
+        ctx = Boolean2D::prepare(c.polyA, c.polyB, epsGeom, epsParam, opts);
+    }));
+
+    // the same prepare() with A prepared once up front, as when clipping many B against it
+    const Boolean2D::PreparedPolygon preparedA(c.polyA, epsGeom, epsParam, opts);
+    Boolean2D::Engine engine;
+    results.push_back(timeStage(c.name + "/preparePrepared", minSeconds, noSetup, [&] {
+        sink += engine.prepare(preparedA, c.polyB, opts).atoms.size();
+    }));
+
+    using ClassifyFn = QVector<Geometry::AtomicSegment> (*)(const Boolean2D::PrepContext&, const InputPolygon&, const InputPolygon&);
+    const QPair<const char*, ClassifyFn> classifiers[] = {
+        {"classifyForAddition",     Boolean2D::classifyForAddition},
+        {"classifyForIntersection", Boolean2D::classifyForIntersection},
+        {"classifyForSubAB",        Boolean2D::classifyForSubAB},
+        {"classifyForSubBA",        Boolean2D::classifyForSubBA},
+    };
+    QVector<Geometry::AtomicSegment> kept;
+    QString keptCounts;
+    for (const auto& cl : classifiers) {
+        results.push_back(timeStage(c.name + "/" + cl.first, minSeconds, noSetup, [&] {
+            kept = cl.second(ctx, c.polyA, c.polyB);
+            sink += kept.size();
+        }));
+        keptCounts += QStringLiteral(" %1 %2").arg(QLatin1String(cl.first)).arg(kept.size());
+    }
+
+    // the SubBA result stays in kept, a mix of both polygons
+    results.push_back(timeStage(c.name + "/segmentsToPolylines", minSeconds, noSetup, [&] {
+        sink += Boolean2D::segmentsToPolylines(kept).size();
+    }));
+
+    benchSink = sink;
+    qInfo().noquote() << "[bench]" << c.name << "atoms:" << ctx.atoms.size() << "kept:" + keptCounts;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("polybool_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Per-stage benchmarks of the boolean pipeline.");
+    parser.addHelpOption();
+    QCommandLineOption outOpt("out", "Write the JSON report to file instead of stdout.", "file");
+    QCommandLineOption filterOpt("filter", "Only run cases whose name contains text.", "text");
+    QCommandLineOption maxSizeOpt("max-size", "Largest vertex count, sizes go 10, 100, ... up to 1000000 (default 100000).", "n", "100000");
+    QCommandLineOption minTimeOpt("min-time", "Minimum timed seconds per stage (default 0.1).", "s", "0.1");
+    QCommandLineOption modeOpt("mode", "Candidate pairs: brute | sweep | grid | rtree (default rtree).", "mode", "rtree");
+    QCommandLineOption threadsOpt("threads", "Threads for the intersection stage, 0 = all cores (default 1).", "n", "1");
+    QCommandLineOption seedOpt("seed", "Seed of the random generators (default 1).", "n", "1");
+    parser.addOption(outOpt);
+    parser.addOption(filterOpt);
+    parser.addOption(maxSizeOpt);
+    parser.addOption(minTimeOpt);
+    parser.addOption(modeOpt);
+    parser.addOption(threadsOpt);
+    parser.addOption(seedOpt);
+    parser.process(app);
+
+    Geometry::AtomizeOptions opts;
+    if (!parseMode(parser.value(modeOpt), opts.mode)) {
+        parser.showHelp(1);
+    }
+    opts.threads = parser.value(threadsOpt).toInt();
+    const int maxSize = parser.value(maxSizeOpt).toInt();
+    const double minSeconds = parser.value(minTimeOpt).toDouble();
+    const QString filter = parser.value(filterOpt);
+
+    using Generator = BenchCase (*)(int, std::mt19937&);
+    const Generator generators[] = {makeStar, makeHoles, makeSawtooth, makeHugeTiny};
+
+    std::mt19937 rng(parser.value(seedOpt).toUInt());
+    QVector<BenchResult> results;
+    for (Generator gen : generators) {
+        for (int n = 10; n <= maxSize; n *= 10) {
+            const BenchCase c = gen(n, rng);
+            if (!filter.isEmpty() && !c.name.contains(filter)) continue;
+            benchCase(c, opts, minSeconds, results);
+        }
+    }
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["executable"] = QCoreApplication::applicationFilePath();
+    context["num_cpus"] = QThread::idealThreadCount();
+#ifdef NDEBUG
+    context["library_build_type"] = "release";
+#else
+    context["library_build_type"] = "debug";
+#endif
+    context["mode"] = parser.value(modeOpt);
+    context["threads"] = opts.threads;
+
+    QJsonArray benchmarks;
+    for (const auto& r : results) {
+        QJsonObject b;
+        b["name"] = r.name;
+        b["run_name"] = r.name;
+        b["run_type"] = "iteration";
+        b["iterations"] = r.iterations;
+        b["real_time"] = r.realTimeNs;
+        b["cpu_time"] = r.realTimeNs; // wall clock only, kept for compare.py
+        b["time_unit"] = "ns";
+        benchmarks.append(b);
+    }
+    QJsonObject root;
+    root["context"] = context;
+    root["benchmarks"] = benchmarks;
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    if (!parser.isSet(outOpt)) {
+        QFile out;
+        if (!out.open(stdout, QIODevice::WriteOnly)) return 3;
+        out.write(json);
+        return 0;
+    }
+    QFile out(parser.value(outOpt));
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical().noquote() << "[bench] cannot write" << out.fileName();
+        return 3;
+    }
+    out.write(json);
+    return 0;
+}
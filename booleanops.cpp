@@ -1,65 +1,34 @@
 #include "booleanops.h"
+#include "pipelinestats.h"
+#include <QHash>
+#include <QRectF>
+#include <QDebug>
+#include <algorithm>
 #include <cmath>
 
-static QVector<QPointF> normalizeLoop(const QVector<QPointF>& inLoop, double epsClose) {
+// points of the loop that make it into the topology: a closing point that
+// repeats the first one is dropped
+static int normalizedLoopSize(const QVector<QPointF>& inLoop, double epsClose) {
     if (inLoop.size() >= 2) {
         const QPointF& a0 = inLoop.front();
         const QPointF& a1 = inLoop.back();
         double dx = a0.x() - a1.x();
         double dy = a0.y() - a1.y();
         if (dx*dx + dy*dy < epsClose*epsClose) {
-            QVector<QPointF> tmp = inLoop;
-            tmp.pop_back();
-            return tmp;
+            return inLoop.size() - 1;
         }
     }
-    return inLoop;
+    return inLoop.size();
 }
 
-static bool pointInSimpleLoop(const QVector<QPointF>& loop, const QPointF& p, double eps = 1e-9) {
-    const int n = loop.size();
-    if (n < 3) return false;
-    for (int i = 0; i < n; ++i) {
-        QPointF a = loop[i];
-        QPointF b = loop[(i+1) % n];
-        QPointF ap = p - a;
-        QPointF ab = b - a;
-        double cross = ap.x() * ab.y() - ap.y() * ab.x();
-        if (std::fabs(cross) < eps) {
-            double dot = ap.x() * ab.x() + ap.y() * ab.y();
-            if (dot >= -eps) {
-                double ab2 = ab.x() * ab.x() + ab.y() * ab.y();
-                if (dot <= ab2 + eps) {
-                    return true;
-                }
-            }
-        }
-    }
-    bool inside = false;
-    for (int i = 0; i < n; ++i) {
-        const QPointF& a = loop[i];
-        const QPointF& b = loop[(i+1)%n];
-        bool condY = ((a.y() > p.y()) != (b.y() > p.y()));
-        if (condY) {
-            double t = (p.y() - a.y()) / (b.y() - a.y());
-            double xHit = a.x() + t * (b.x() - a.x());
-            if (xHit >= p.x() - eps) {
-                inside = !inside;
-            }
-        }
-    }
-    return inside;
+// prepare() fills the locators; contexts assembled by hand get them built here
+static const Boolean2D::PointLocator& locatorFor(const Boolean2D::PointLocator& cached, const InputPolygon& poly, Boolean2D::PointLocator& scratch) {
+    if (!cached.isEmpty()) return cached;
+    scratch.build(poly);
+    return scratch;
 }
 
-static bool pointInPolygonWithHoles(const InputPolygon& poly, const QPointF& p) {
-    if (!pointInSimpleLoop(poly.outerLoop(), p)) return false;
-    for (const auto& h : poly.holeLoops()) {
-        if (pointInSimpleLoop(h, p)) return false;
-    }
-    return true;
-}
-
-static bool coincidentOpposite(const Geometry::AtomicSegment& seg, const InputPolygon& polyA, const InputPolygon& polyB) {
+static bool coincidentOpposite(const Geometry::AtomicSegment& seg, const Boolean2D::PointLocator& locA, const Boolean2D::PointLocator& locB, qint64& pipCalls) {
     QPointF mid(0.5 * (seg.p0.x() + seg.p1.x()), 0.5 * (seg.p0.y() + seg.p1.y()));
     QPointF dir(seg.p1.x() - seg.p0.x(), seg.p1.y() - seg.p0.y());
     QPointF n(dir.y(), -dir.x());
@@ -72,24 +41,106 @@ static bool coincidentOpposite(const Geometry::AtomicSegment& seg, const InputPo
     const double epsProbe = 1e-4;
     QPointF pPlus(mid.x() + epsProbe * n.x(), mid.y() + epsProbe * n.y());
     QPointF pMinus(mid.x() - epsProbe * n.x(), mid.y() - epsProbe * n.y());
-    bool inA_plus = pointInPolygonWithHoles(polyA, pPlus);
-    bool inA_minus = pointInPolygonWithHoles(polyA, pMinus);
-    bool inB_plus = pointInPolygonWithHoles(polyB, pPlus);
-    bool inB_minus = pointInPolygonWithHoles(polyB, pMinus);
+    pipCalls += 4;
+    bool inA_plus = locA.contains(pPlus);
+    bool inA_minus = locA.contains(pMinus);
+    bool inB_plus = locB.contains(pPlus);
+    bool inB_minus = locB.contains(pMinus);
     bool oppCase1 = inA_plus && !inB_plus && !inA_minus && inB_minus;
     bool oppCase2 = !inA_plus && inB_plus && inA_minus && !inB_minus;
     return (oppCase1 || oppCase2);
 }
 
-static QVector<QVector<QPointF>> segmentsToPolylines(
-    const QVector<Geometry::AtomicSegment>& segs) {
-    QVector<QVector<QPointF>> out;
-    out.reserve(segs.size());
-    for (const auto& s : segs) {
-        QVector<QPointF> line;
-        line.push_back(s.p0);
-        line.push_back(s.p1);
-        out.push_back(line);
+// everything the classifiers ask about an atom, computed once per atom;
+// in/out of coincident atoms is only filled in Propagate mode, where it is
+// carried on to their successor
+static void atomMembership(const Boolean2D::PrepContext& ctx, const Boolean2D::PointLocator& locA, const Boolean2D::PointLocator& locB,
+                           QVector<Boolean2D::AtomStatus>& status) {
+    status.fill(Boolean2D::AtomStatus(), ctx.atoms.size());
+    const bool propagate = (ctx.classifyMode == Boolean2D::ClassifyMode::Propagate);
+    qint64 pipCalls = 0;
+    for (int k = 0; k < ctx.atoms.size(); ++k) {
+        if ((k & 4095) == 0) {
+            if (Geometry::cancelRequested()) break;
+            Geometry::reportProgress(Geometry::PipelineStage::Classify, double(k) / ctx.atoms.size());
+        }
+        const auto& seg = ctx.atoms[k];
+        if (seg.coincidentWithOther) {
+            status[k].opposite = coincidentOpposite(seg, locA, locB, pipCalls);
+        }
+        if (propagate && k > 0 && seg.link != Geometry::StatusLink::Retest) {
+            // opposite belongs to this atom, only the in/out status carries over
+            status[k].inA = status[k-1].inA;
+            status[k].inB = status[k-1].inB;
+            if (seg.link == Geometry::StatusLink::FlipOther) {
+                if (seg.fromA) status[k].inB = !status[k].inB;
+                else           status[k].inA = !status[k].inA;
+            }
+            continue;
+        }
+        if (!propagate && seg.coincidentWithOther) continue;
+        QPointF mid(0.5 * (seg.p0.x() + seg.p1.x()), 0.5 * (seg.p0.y() + seg.p1.y()));
+        status[k].inA = locA.contains(mid);
+        status[k].inB = locB.contains(mid);
+        pipCalls += 2;
+    }
+    if (Geometry::PipelineStats* stats = Geometry::activeStats()) stats->pipCalls += pipCalls;
+}
+
+static double signedArea(const QVector<QPointF>& ring) {
+    double a = 0.0;
+    const int n = ring.size();
+    for (int i = 0; i < n; ++i) {
+        const QPointF& p = ring[i];
+        const QPointF& q = ring[(i+1) % n];
+        a += p.x() * q.y() - q.x() * p.y();
+    }
+    return 0.5 * a;
+}
+
+static bool ringContains(const QVector<QPointF>& ring, const QPointF& p) {
+    bool inside = false;
+    const int n = ring.size();
+    for (int i = 0; i < n; ++i) {
+        const QPointF& a = ring[i];
+        const QPointF& b = ring[(i+1) % n];
+        if ((a.y() > p.y()) != (b.y() > p.y())) {
+            double xHit = a.x() + (p.y() - a.y()) / (b.y() - a.y()) * (b.x() - a.x());
+            if (xHit > p.x()) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// drops vertices lying within eps of the segment between their neighbours,
+// i.e. the cut points left between consecutive atoms of one input edge
+static QVector<QPointF> dropCollinear(const QVector<QPointF>& ring, double eps) {
+    auto onSpan = [eps](const QPointF& a, const QPointF& b, const QPointF& c) {
+        QPointF ab = b - a;
+        QPointF ac = c - a;
+        double ac2 = ac.x() * ac.x() + ac.y() * ac.y();
+        if (ac2 <= 0.0) return false;
+        double cross = ab.x() * ac.y() - ab.y() * ac.x();
+        double dot   = ab.x() * ac.x() + ab.y() * ac.y();
+        return dot > 0.0 && dot < ac2 && cross * cross <= eps * eps * ac2;
+    };
+    QVector<QPointF> out = ring;
+    bool changed = true;
+    while (changed && out.size() > 3) {
+        changed = false;
+        QVector<QPointF> next;
+        next.reserve(out.size());
+        const int n = out.size();
+        for (int i = 0; i < n; ++i) {
+            const QPointF& a = next.isEmpty() ? out[n-1] : next.last();
+            const bool keepsThree = next.size() + (n - i - 1) >= 3;
+            if (keepsThree && onSpan(a, out[i], out[(i+1) % n])) {
+                changed = true;
+                continue;
+            }
+            next.push_back(out[i]);
+        }
+        out = next;
     }
     return out;
 }
@@ -97,155 +148,227 @@ static QVector<QVector<QPointF>> segmentsToPolylines(
 namespace Boolean2D {
 Geometry::PolygonTopo makeTopoFromInput(const InputPolygon& poly, double epsClose) {
     Geometry::PolygonTopo topo;
-    topo.verts.clear();
-    topo.loops.clear();
-    auto appendLoop = [&](const QVector<QPointF>& rawLoopPts) {
-        QVector<QPointF> L = normalizeLoop(rawLoopPts, epsClose);
-        if (L.size() < 3)
+    makeTopoFromInput(poly, topo, epsClose);
+    return topo;
+}
+
+void makeTopoFromInput(const InputPolygon& poly, Geometry::PolygonTopo& topo, double epsClose) {
+    // loops are overwritten in place, so their vertex lists keep their capacity
+    topo.verts.resize(0);
+    int loopCount = 0;
+    auto appendLoop = [&](const QVector<QPointF>& rawLoopPts, bool isHole) {
+        const int n = normalizedLoopSize(rawLoopPts, epsClose);
+        if (n < 3)
             return;
-        Geometry::LoopTopo loopTopo;
-        loopTopo.loopVertices.reserve(L.size());
-        for (const QPointF& pt : L) {
+        if (loopCount == topo.loops.size()) topo.loops.push_back(Geometry::LoopTopo());
+        Geometry::LoopTopo& loopTopo = topo.loops[loopCount++];
+        loopTopo.isHole = isHole;
+        loopTopo.loopVertices.resize(0);
+        loopTopo.loopVertices.reserve(n);
+        for (int i = 0; i < n; ++i) {
             Geometry::Vertex v;
-            v.pos = pt;
+            v.pos = rawLoopPts[i];
             int idx = topo.verts.size();
             topo.verts.push_back(v);
             loopTopo.loopVertices.push_back(idx);
         }
-        topo.loops.push_back(loopTopo);
     };
-    appendLoop(poly.outerLoop());
+    appendLoop(poly.outerLoop(), false);
     for (const auto& h : poly.holeLoops()) {
-        appendLoop(h);
+        appendLoop(h, true);
     }
-    return topo;
+    topo.loops.resize(loopCount);
+}
+
+// PrepContext::turnedA / turnedB for one side; loop 0 is the outer loop
+static void loopTurns(const Geometry::PolygonTopo& topo, QVector<char>& turned) {
+    turned.resize(topo.loops.size());
+    for (int l = 0; l < topo.loops.size(); ++l) {
+        const QVector<int>& lv = topo.loops[l].loopVertices;
+        const int n = lv.size();
+        double a = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const QPointF& p = topo.verts[lv[i]].pos;
+            const QPointF& q = topo.verts[lv[(i+1) % n]].pos;
+            a += p.x() * q.y() - q.x() * p.y();
+        }
+        turned[l] = (l == 0) ? a < 0.0 : a > 0.0;
+    }
+}
+
+static void assignTopo(const InputPolygon& poly, Geometry::PolygonTopo& topo) {
+    makeTopoFromInput(poly, topo);
 }
 
-PrepContext prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom, double epsParam) {
+// a copy of implicitly shared data, the caller's topology is not written
+static void assignTopo(const Geometry::PolygonTopo& from, Geometry::PolygonTopo& topo) {
+    topo = from;
+}
+
+// prepare() on storage the caller keeps, the classify mode of ctx is left
+// alone; Side is an InputPolygon or a PolygonTopo
+template<class Side>
+static void prepareInto(PrepContext& ctx, Geometry::AtomizeBuffers& buffers, const Side& polyA, const Side& polyB,
+                        double epsGeom, double epsParam, const Geometry::AtomizeOptions& opts) {
+    ctx.stats = Geometry::PipelineStats();
+    Geometry::PipelineStats* outer = Geometry::activeStats();
+    {
+        Geometry::StatsScope scope(outer ? &ctx.stats : nullptr);
+        assignTopo(polyA, ctx.topoA);
+        assignTopo(polyB, ctx.topoB);
+        loopTurns(ctx.topoA, ctx.turnedA);
+        loopTurns(ctx.topoB, ctx.turnedB);
+        Geometry::computeAtomicSegments(ctx.topoA, ctx.topoB, epsGeom, epsParam, opts, buffers, ctx.atoms);
+        Geometry::StageTimer timer(&Geometry::PipelineStats::locatorNs);
+        ctx.locA.build(polyA);
+        ctx.locB.build(polyB);
+    }
+    if (outer) *outer += ctx.stats;
+}
+
+PrepContext prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom, double epsParam, const Geometry::AtomizeOptions& opts) {
     PrepContext ctx;
-    ctx.topoA = makeTopoFromInput(polyA);
-    ctx.topoB = makeTopoFromInput(polyB);
-    ctx.atoms = Geometry::computeAtomicSegments(ctx.topoA, ctx.topoB, epsGeom, epsParam);
+    Geometry::AtomizeBuffers buffers;
+    prepareInto(ctx, buffers, polyA, polyB, epsGeom, epsParam, opts);
     return ctx;
 }
 
-static QVector<Geometry::AtomicSegment> classifyForAddition(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
-    QVector<Geometry::AtomicSegment> keep;
-    keep.reserve(ctx.atoms.size());
-    for (const auto& seg : ctx.atoms) {
-        if (seg.coincidentWithOther) {
-            bool opp = coincidentOpposite(seg, polyA, polyB);
-            if (!opp) {
-                if (seg.fromA) keep.push_back(seg);
-            }
-            continue;
-        }
-        QPointF mid(0.5 * (seg.p0.x() + seg.p1.x()), 0.5 * (seg.p0.y() + seg.p1.y()));
-        bool inA = pointInPolygonWithHoles(polyA, mid);
-        bool inB = pointInPolygonWithHoles(polyB, mid);
-        bool useIt = false;
-        if (seg.fromA) {
-            if (!inB) useIt = true;
-        } else {
-            if (!inA) useIt = true;
-        }
-        if (useIt) keep.push_back(seg);
+PreparedPolygon::PreparedPolygon(const InputPolygon& poly, double epsGeom, double epsParam, const Geometry::AtomizeOptions& opts)
+    : opts_(opts) {
+    makeTopoFromInput(poly, topo_);
+    loopTurns(topo_, turned_);
+    Geometry::prepareEdges(topo_, /*fromA=*/true, epsGeom, epsParam, opts.simpleA, edges_);
+    if (opts.mode == Geometry::IntersectMode::GridIndex || opts.mode == Geometry::IntersectMode::RTreeIndex) {
+        Geometry::StageTimer timer(&Geometry::PipelineStats::intersectNs);
+        index_.build(Geometry::edgeBoxes(edges_.arr), opts.mode == Geometry::IntersectMode::GridIndex
+                                                          ? Geometry::EdgeIndex::Backend::Grid
+                                                          : Geometry::EdgeIndex::Backend::RTree);
     }
-    return keep;
+    Geometry::StageTimer timer(&Geometry::PipelineStats::locatorNs);
+    loc_.build(poly);
 }
 
-static QVector<Geometry::AtomicSegment> classifyForIntersection(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
-    QVector<Geometry::AtomicSegment> keep;
-    keep.reserve(ctx.atoms.size());
-    for (const auto& seg : ctx.atoms) {
-        if (seg.coincidentWithOther) {
-            bool opp = coincidentOpposite(seg, polyA, polyB);
-            if (!opp) {
-                if (seg.fromA)
-                    keep.push_back(seg);
-            }
-            continue;
-        }
-        QPointF mid(0.5 * (seg.p0.x() + seg.p1.x()), 0.5 * (seg.p0.y() + seg.p1.y()));
-        bool inA = pointInPolygonWithHoles(polyA, mid);
-        bool inB = pointInPolygonWithHoles(polyB, mid);
-        bool useIt = false;
-        if (seg.fromA) {
-            if (inB) useIt = true;
-        } else {
-            if (inA) useIt = true;
-        }
-        if (useIt) keep.push_back(seg);
+static bool keepForAddition(const Geometry::AtomicSegment& seg, const AtomStatus& st) {
+    if (seg.coincidentWithOther) {
+        return !st.opposite && seg.fromA;
     }
-    return keep;
+    if (seg.fromA) return !st.inB;
+    return !st.inA;
 }
 
-static QVector<Geometry::AtomicSegment> classifyForSubAB(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
-    QVector<Geometry::AtomicSegment> keep;
-    keep.reserve(ctx.atoms.size());
-    for (const auto& seg : ctx.atoms) {
-        if (seg.coincidentWithOther) {
-            bool opp = coincidentOpposite(seg, polyA, polyB);
-            if (opp) {
-                if (seg.fromA)
-                    keep.push_back(seg);
-            }
-            continue;
-        }
-        QPointF mid(0.5 * (seg.p0.x() + seg.p1.x()), 0.5 * (seg.p0.y() + seg.p1.y()));
-        bool inA = pointInPolygonWithHoles(polyA, mid);
-        bool inB = pointInPolygonWithHoles(polyB, mid);
-        bool useIt = false;
-        if (seg.fromA) {
-            if (seg.loopId > 0) {
-                if (!inB) useIt = true;
-            } else {
-                if (inA && !inB) useIt = true;
-            }
-        } else {
-            if (seg.loopId > 0) {
-                if (inA && !inB) useIt = true;
-            } else {
-                if (inA && inB) useIt = true;
-            }
-        }
-        if (useIt) keep.push_back(seg);
+static bool keepForIntersection(const Geometry::AtomicSegment& seg, const AtomStatus& st) {
+    if (seg.coincidentWithOther) {
+        return !st.opposite && seg.fromA;
     }
-    return keep;
+    if (seg.fromA) return st.inB;
+    return st.inA;
 }
 
-static QVector<Geometry::AtomicSegment> classifyForSubBA(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
-    QVector<Geometry::AtomicSegment> keep;
-    keep.reserve(ctx.atoms.size());
-    for (const auto& seg : ctx.atoms) {
-        if (seg.coincidentWithOther) {
-            bool opp = coincidentOpposite(seg, polyA, polyB);
-            if (opp) {
-                if (!seg.fromA)
-                    keep.push_back(seg);
-            }
-            continue;
-        }
-        QPointF mid(0.5*(seg.p0.x()+seg.p1.x()), 0.5*(seg.p0.y()+seg.p1.y()));
-        bool inA = pointInPolygonWithHoles(polyA, mid);
-        bool inB = pointInPolygonWithHoles(polyB, mid);
-        bool useIt = false;
-        if (!seg.fromA) {
-            if (seg.loopId > 0) {
-                if (!inA) useIt = true;
-            } else {
-                if (inB && !inA) useIt = true;
-            }
-        } else {
-            if (seg.loopId > 0) {
-                if (inB && !inA) useIt = true;
-            } else {
-                if (inA && inB) useIt = true;
-            }
-        }
-        if (useIt) keep.push_back(seg);
+static bool keepForSubAB(const Geometry::AtomicSegment& seg, const AtomStatus& st) {
+    if (seg.coincidentWithOther) {
+        return st.opposite && seg.fromA;
+    }
+    if (seg.fromA) {
+        if (seg.loopId > 0) return !st.inB;
+        return st.inA && !st.inB;
+    }
+    if (seg.loopId > 0) return st.inA && !st.inB;
+    return st.inA && st.inB;
+}
+
+static bool keepForSubBA(const Geometry::AtomicSegment& seg, const AtomStatus& st) {
+    if (seg.coincidentWithOther) {
+        return st.opposite && !seg.fromA;
+    }
+    if (!seg.fromA) {
+        if (seg.loopId > 0) return !st.inA;
+        return st.inB && !st.inA;
+    }
+    if (seg.loopId > 0) return st.inB && !st.inA;
+    return st.inA && st.inB;
+}
+
+using KeepFn = bool (*)(const Geometry::AtomicSegment&, const AtomStatus&);
+
+static KeepFn keepFor(Operation op) {
+    switch (op) {
+    case Operation::Addition:     return keepForAddition;
+    case Operation::Intersection: return keepForIntersection;
+    case Operation::SubAB:        return keepForSubAB;
+    case Operation::SubBA:        return keepForSubBA;
+    }
+    return keepForAddition;
+}
+
+// The atoms op keeps, each turned so that the result lies on its left. An
+// atom has its own polygon's interior on the left once its loop runs the
+// right way round; atoms of the subtracted side are reversed on top of that.
+static void keepAtoms(const PrepContext& ctx, const QVector<AtomStatus>& status, Operation op,
+                      QVector<Geometry::AtomicSegment>& kept) {
+    const KeepFn keep = keepFor(op);
+    const bool reverseA = (op == Operation::SubBA);
+    const bool reverseB = (op == Operation::SubAB);
+    // contexts assembled by hand come without the loop flags
+    QVector<char> scratchA, scratchB;
+    const QVector<char>* turnedA = &ctx.turnedA;
+    const QVector<char>* turnedB = &ctx.turnedB;
+    if (turnedA->size() != ctx.topoA.loops.size()) { loopTurns(ctx.topoA, scratchA); turnedA = &scratchA; }
+    if (turnedB->size() != ctx.topoB.loops.size()) { loopTurns(ctx.topoB, scratchB); turnedB = &scratchB; }
+    kept.resize(0);
+    kept.reserve(ctx.atoms.size());
+    for (int k = 0; k < ctx.atoms.size(); ++k) {
+        const Geometry::AtomicSegment& seg = ctx.atoms[k];
+        if (!keep(seg, status[k])) continue;
+        kept.push_back(seg);
+        const bool reverse = seg.fromA ? (reverseA != bool((*turnedA)[seg.loopId]))
+                                       : (reverseB != bool((*turnedB)[seg.loopId]));
+        if (reverse) std::swap(kept.last().p0, kept.last().p1);
+    }
+    if (Geometry::PipelineStats* stats = Geometry::activeStats()) stats->atomsKept += kept.size();
+}
+
+static QVector<Geometry::AtomicSegment> keepAtoms(const PrepContext& ctx, const QVector<AtomStatus>& status, Operation op) {
+    QVector<Geometry::AtomicSegment> kept;
+    keepAtoms(ctx, status, op, kept);
+    return kept;
+}
+
+static QVector<AtomStatus> classifyAtoms(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    Geometry::StageTimer timer(&Geometry::PipelineStats::classifyNs);
+    PointLocator scratchA, scratchB;
+    const PointLocator& locA = locatorFor(ctx.locA, polyA, scratchA);
+    const PointLocator& locB = locatorFor(ctx.locB, polyB, scratchB);
+    QVector<AtomStatus> status;
+    atomMembership(ctx, locA, locB, status);
+    return status;
+}
+
+QVector<Geometry::AtomicSegment> classifyForAddition(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    return keepAtoms(ctx, classifyAtoms(ctx, polyA, polyB), Operation::Addition);
+}
+
+QVector<Geometry::AtomicSegment> classifyForIntersection(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    return keepAtoms(ctx, classifyAtoms(ctx, polyA, polyB), Operation::Intersection);
+}
+
+QVector<Geometry::AtomicSegment> classifyForSubAB(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    return keepAtoms(ctx, classifyAtoms(ctx, polyA, polyB), Operation::SubAB);
+}
+
+QVector<Geometry::AtomicSegment> classifyForSubBA(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    return keepAtoms(ctx, classifyAtoms(ctx, polyA, polyB), Operation::SubBA);
+}
+
+QVector<QVector<QPointF>> segmentsToPolylines(const QVector<Geometry::AtomicSegment>& segs) {
+    QVector<QVector<QPointF>> out;
+    out.reserve(segs.size());
+    for (const auto& s : segs) {
+        QVector<QPointF> line;
+        line.push_back(s.p0);
+        line.push_back(s.p1);
+        out.push_back(line);
     }
-    return keep;
+    return out;
 }
 
 QVector<QVector<QPointF>> computeAdditionSegments(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
@@ -268,4 +391,268 @@ QVector<QVector<QPointF>> computeSubtractionBASegments(const PrepContext& ctx, c
     return segmentsToPolylines(kept);
 }
 
+BooleanResults classifyAll(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB) {
+    const QVector<AtomStatus> status = classifyAtoms(ctx, polyA, polyB);
+    BooleanResults res;
+    res.addition      = segmentsToPolylines(keepAtoms(ctx, status, Operation::Addition));
+    res.intersection  = segmentsToPolylines(keepAtoms(ctx, status, Operation::Intersection));
+    res.subtractionAB = segmentsToPolylines(keepAtoms(ctx, status, Operation::SubAB));
+    res.subtractionBA = segmentsToPolylines(keepAtoms(ctx, status, Operation::SubBA));
+    return res;
+}
+
+const PrepContext& Engine::prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom, double epsParam,
+                                   const Geometry::AtomizeOptions& opts) {
+    prepareInto(ctx_, buffers_, polyA, polyB, epsGeom, epsParam, opts);
+    return ctx_;
+}
+
+const PrepContext& Engine::prepare(const Geometry::PolygonTopo& topoA, const Geometry::PolygonTopo& topoB, double epsGeom, double epsParam,
+                                   const Geometry::AtomizeOptions& opts) {
+    prepareInto(ctx_, buffers_, topoA, topoB, epsGeom, epsParam, opts);
+    return ctx_;
+}
+
+void Engine::classify(Operation op, QVector<Geometry::AtomicSegment>& out) {
+    {
+        Geometry::StageTimer timer(&Geometry::PipelineStats::classifyNs);
+        atomMembership(ctx_, ctx_.locA, ctx_.locB, status_);
+    }
+    keepAtoms(ctx_, status_, op, out);
+}
+
+void Engine::run(Operation op, const InputPolygon& polyA, const InputPolygon& polyB, QVector<Geometry::AtomicSegment>& out,
+                 double epsGeom, double epsParam, const Geometry::AtomizeOptions& opts) {
+    prepare(polyA, polyB, epsGeom, epsParam, opts);
+    classify(op, out);
+}
+
+void Engine::run(Operation op, const Geometry::PolygonTopo& topoA, const Geometry::PolygonTopo& topoB, QVector<Geometry::AtomicSegment>& out,
+                 double epsGeom, double epsParam, const Geometry::AtomizeOptions& opts) {
+    prepare(topoA, topoB, epsGeom, epsParam, opts);
+    classify(op, out);
+}
+
+const PrepContext& Engine::prepare(const PreparedPolygon& polyA, const InputPolygon& polyB, const Geometry::AtomizeOptions& opts) {
+    Geometry::AtomizeOptions o = opts;
+    o.mode    = polyA.opts_.mode;
+    o.simpleA = polyA.opts_.simpleA;
+    ctx_.stats = Geometry::PipelineStats();
+    Geometry::PipelineStats* outer = Geometry::activeStats();
+    {
+        Geometry::StatsScope scope(outer ? &ctx_.stats : nullptr);
+        // copies of implicitly shared data, the prepared polygon is not written
+        ctx_.topoA   = polyA.topo_;
+        ctx_.turnedA = polyA.turned_;
+        makeTopoFromInput(polyB, ctx_.topoB);
+        loopTurns(ctx_.topoB, ctx_.turnedB);
+        Geometry::computeAtomicSegments(ctx_.topoA, polyA.edges_, &polyA.index_, ctx_.topoB, o, buffers_, ctx_.atoms);
+        Geometry::StageTimer timer(&Geometry::PipelineStats::locatorNs);
+        ctx_.locA = polyA.loc_;
+        ctx_.locB.build(polyB);
+    }
+    if (outer) *outer += ctx_.stats;
+    return ctx_;
+}
+
+void Engine::run(Operation op, const PreparedPolygon& polyA, const InputPolygon& polyB, QVector<Geometry::AtomicSegment>& out,
+                 const Geometry::AtomizeOptions& opts) {
+    prepare(polyA, polyB, opts);
+    classify(op, out);
+}
+
+const PrepContext& PrepCache::get(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom, double epsParam,
+                                  const Geometry::AtomizeOptions& opts) {
+    Key key;
+    key.versionA = polyA.version();
+    key.versionB = polyB.version();
+    key.epsGeom  = epsGeom;
+    key.epsParam = epsParam;
+    key.mode     = opts.mode;
+    key.simpleA  = opts.simpleA;
+    key.simpleB  = opts.simpleB;
+    lastHit_ = valid_ && key == key_;
+    if (!lastHit_) {
+        ctx_   = prepare(polyA, polyB, epsGeom, epsParam, opts);
+        key_   = key;
+        valid_ = !Geometry::cancelRequested(); // a canceled prepare left partial atoms
+    }
+    return ctx_;
+}
+
+void PrepCache::invalidate() noexcept {
+    valid_ = false;
+    ctx_   = PrepContext();
+}
+
+QVector<InputPolygon> stitchSegments(const QVector<QVector<QPointF>>& segments, double epsSnap) {
+    // vertex welding: a point joins an existing vertex within epsSnap found in
+    // its own or a neighbouring snap cell
+    QVector<QPointF> verts;
+    QHash<QPair<qint64, qint64>, int> cellVertex;
+    auto vertexId = [&](const QPointF& p) {
+        const qint64 cx = qint64(std::floor(p.x() / epsSnap));
+        const qint64 cy = qint64(std::floor(p.y() / epsSnap));
+        for (qint64 dy = -1; dy <= 1; ++dy) {
+            for (qint64 dx = -1; dx <= 1; ++dx) {
+                auto it = cellVertex.constFind(qMakePair(cx + dx, cy + dy));
+                if (it == cellVertex.constEnd()) continue;
+                const QPointF& q = verts[it.value()];
+                if (std::fabs(q.x() - p.x()) <= epsSnap && std::fabs(q.y() - p.y()) <= epsSnap) {
+                    return it.value();
+                }
+            }
+        }
+        const int id = verts.size();
+        verts.push_back(p);
+        cellVertex.insert(qMakePair(cx, cy), id);
+        return id;
+    };
+
+    QVector<QPair<int, int>> edges; // directed, result on the left
+    for (int s = 0; s < segments.size(); ++s) {
+        if ((s & 4095) == 0 && Geometry::cancelRequested()) return {};
+        const auto& line = segments[s];
+        for (int k = 0; k + 1 < line.size(); ++k) {
+            const int u = vertexId(line[k]);
+            const int v = vertexId(line[k+1]);
+            if (u != v) edges.push_back(qMakePair(u, v));
+        }
+    }
+
+    // CSR lists of the edges leaving each vertex
+    QVector<int> outStart(verts.size() + 1, 0);
+    for (const auto& e : edges) ++outStart[e.first + 1];
+    for (int v = 0; v < verts.size(); ++v) outStart[v + 1] += outStart[v];
+    QVector<int> outEdges(outStart.last());
+    QVector<int> fill = outStart;
+    for (int k = 0; k < edges.size(); ++k) outEdges[fill[edges[k].first]++] = k;
+    QVector<char> used(edges.size(), 0);
+    // Leaving v after arriving by edge in, take the unused edge that turns
+    // furthest left, going straight back last. Where rings touch at a vertex
+    // this keeps each ring to itself instead of crossing into the other.
+    auto takeEdgeAt = [&](int v, int in) {
+        const QPointF d = verts[v] - verts[edges[in].first];
+        int best = -1;
+        double bestTurn = 0.0;
+        for (int c = outStart[v]; c < outStart[v + 1]; ++c) {
+            const int k = outEdges[c];
+            if (used[k]) continue;
+            const QPointF e = verts[edges[k].second] - verts[v];
+            const double cross = d.x() * e.y() - d.y() * e.x();
+            const double dot   = d.x() * e.x() + d.y() * e.y();
+            const double turn  = (cross == 0.0 && dot < 0.0) ? -4.0 : std::atan2(cross, dot); // below any atan2
+            if (best < 0 || turn > bestTurn) {
+                best = k;
+                bestTurn = turn;
+            }
+        }
+        return best;
+    };
+
+    // A walk that comes back to a vertex it already passed closes a ring
+    // there, e.g. a hole touching the outer ring at a point; the walk goes on
+    // from that vertex.
+    QVector<QVector<QPointF>> rings;
+    auto addRing = [&](const QVector<int>& chain, int from) {
+        QVector<QPointF> ring;
+        ring.reserve(chain.size() - from);
+        for (int c = from; c < chain.size(); ++c) ring.push_back(verts[chain[c]]);
+        ring = dropCollinear(ring, epsSnap);
+        if (ring.size() >= 3) rings.push_back(ring);
+    };
+    QVector<int> chainPos(verts.size(), -1);
+    QVector<int> chain;
+    int openChains = 0;
+    for (int k0 = 0; k0 < edges.size(); ++k0) {
+        if ((k0 & 4095) == 0 && Geometry::cancelRequested()) return {};
+        if (used[k0]) continue;
+        used[k0] = 1;
+        const int start = edges[k0].first;
+        chain = { start };
+        chainPos[start] = 0;
+        int in = k0;
+        int cur = edges[k0].second;
+        while (cur != start) {
+            if (chainPos[cur] >= 0) {
+                const int from = chainPos[cur];
+                addRing(chain, from);
+                for (int c = from + 1; c < chain.size(); ++c) chainPos[chain[c]] = -1;
+                chain.resize(from + 1);
+            } else {
+                chainPos[cur] = chain.size();
+                chain.push_back(cur);
+            }
+            const int k = takeEdgeAt(cur, in);
+            if (k < 0) break;
+            used[k] = 1;
+            in = k;
+            cur = edges[k].second;
+        }
+        if (cur != start) ++openChains;
+        addRing(chain, 0);
+        for (int v : chain) chainPos[v] = -1;
+    }
+    if (openChains > 0) {
+        qWarning() << "[Boolean2D] stitchSegments: open chains closed implicitly:" << openChains;
+    }
+
+    // Orientation tells outer rings (counter-clockwise) from holes; a hole
+    // goes to the smallest outer ring around it.
+    const int R = rings.size();
+    QVector<double> area(R);
+    QVector<QRectF> bbox(R);
+    for (int r = 0; r < R; ++r) {
+        area[r] = signedArea(rings[r]);
+        double minx = rings[r][0].x(), maxx = minx, miny = rings[r][0].y(), maxy = miny;
+        for (const auto& p : rings[r]) {
+            minx = std::min(minx, p.x()); maxx = std::max(maxx, p.x());
+            miny = std::min(miny, p.y()); maxy = std::max(maxy, p.y());
+        }
+        bbox[r] = QRectF(QPointF(minx, miny), QPointF(maxx, maxy));
+    }
+
+    QVector<InputPolygon> out;
+    QVector<int> polyOf(R, -1);
+    QVector<QVector<QPointF>> outerLoops;
+    QVector<QVector<QVector<QPointF>>> holeLoops;
+    for (int r = 0; r < R; ++r) {
+        if (area[r] < 0.0) continue;
+        polyOf[r] = outerLoops.size();
+        outerLoops.push_back(rings[r]);
+        holeLoops.push_back({});
+    }
+    int orphanHoles = 0;
+    for (int r = 0; r < R; ++r) {
+        // each hole scans every outer ring
+        if ((r & 63) == 0 && Geometry::cancelRequested()) return {};
+        if (area[r] >= 0.0) continue;
+        const QPointF probe = 0.5 * (rings[r][0] + rings[r][1]);
+        int parent = -1;
+        for (int o = 0; o < R; ++o) {
+            if (area[o] < 0.0 || area[o] <= -area[r]) continue;
+            if (parent >= 0 && area[o] >= area[parent]) continue;
+            if (bbox[o].contains(probe) && ringContains(rings[o], probe)) parent = o;
+        }
+        if (parent >= 0) {
+            holeLoops[polyOf[parent]].push_back(rings[r]);
+            continue;
+        }
+        // nothing to attach it to, kept as an outer ring of its own
+        ++orphanHoles;
+        QVector<QPointF> ring = rings[r];
+        std::reverse(ring.begin(), ring.end());
+        outerLoops.push_back(ring);
+        holeLoops.push_back({});
+    }
+    if (orphanHoles > 0) {
+        qWarning() << "[Boolean2D] stitchSegments: holes outside every outer ring, kept as outer rings:" << orphanHoles;
+    }
+    out.resize(outerLoops.size());
+    for (int p = 0; p < outerLoops.size(); ++p) {
+        out[p].setLoops(outerLoops[p], holeLoops[p]);
+    }
+    return out;
+}
+
 }
@@ -3,18 +3,70 @@
 #include <QPointF>
 #include "inputpolygon.h"
 #include "geometrymodel.h"
+#include "edgeindex.h"
+#include "pointlocator.h"
+#include "pipelinestats.h"
 
 namespace Boolean2D {
 
+enum class ClassifyMode {
+    PointTests, // midpoint point-in-polygon test for every atom
+    Propagate // test one atom per run, carry the status along StatusLink
+};
+
 struct PrepContext {
     Geometry::PolygonTopo topoA;
     Geometry::PolygonTopo topoB;
     QVector<Geometry::AtomicSegment> atoms;
+    // per loop of topoA / topoB: set when it runs with its interior on the
+    // right, i.e. a clockwise outer loop or a counter-clockwise hole
+    QVector<char> turnedA;
+    QVector<char> turnedB;
+    PointLocator locA; // point location for the classifiers, reused by every operation
+    PointLocator locB;
+    ClassifyMode classifyMode = ClassifyMode::PointTests;
+    Geometry::PipelineStats stats; // prepare() stages, filled when a StatsScope was open
+};
+
+enum class Operation {
+    Addition,
+    Intersection,
+    SubAB,
+    SubBA
+};
+
+// in/out of one atom as the classifiers see it
+struct AtomStatus {
+    bool inA = false;
+    bool inB = false;
+    bool opposite = false; // coincident atoms only, interiors on opposite sides
+};
+
+struct BooleanResults {
+    QVector<QVector<QPointF>> addition;
+    QVector<QVector<QPointF>> intersection;
+    QVector<QVector<QPointF>> subtractionAB;
+    QVector<QVector<QPointF>> subtractionBA;
 };
 
 Geometry::PolygonTopo makeTopoFromInput(const InputPolygon& poly, double epsClose = 1e-9);
+void makeTopoFromInput(const InputPolygon& poly, Geometry::PolygonTopo& topo, double epsClose = 1e-9);
 
-PrepContext prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom = 1e-3, double epsParam = 1e-3);
+PrepContext prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom = 1e-3, double epsParam = 1e-3,
+                    const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+
+// the atoms each operation keeps, before conversion to polylines, turned so
+// that the result lies on their left; point tests and kept atoms are counted
+// into the active Geometry::StatsScope
+QVector<Geometry::AtomicSegment> classifyForAddition(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
+
+QVector<Geometry::AtomicSegment> classifyForIntersection(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
+
+QVector<Geometry::AtomicSegment> classifyForSubAB(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
+
+QVector<Geometry::AtomicSegment> classifyForSubBA(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
+
+QVector<QVector<QPointF>> segmentsToPolylines(const QVector<Geometry::AtomicSegment>& segs);
 
 QVector<QVector<QPointF>> computeAdditionSegments(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
 
@@ -24,4 +76,106 @@ QVector<QVector<QPointF>> computeSubtractionABSegments(const PrepContext& ctx, c
 
 QVector<QVector<QPointF>> computeSubtractionBASegments(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
 
+// all four operations from a single membership pass over the atoms
+BooleanResults classifyAll(const PrepContext& ctx, const InputPolygon& polyA, const InputPolygon& polyB);
+
+// Chains result segments into closed rings through an endpoint hash on
+// coordinates snapped to epsSnap, normally the epsGeom of the operation. The
+// segments are directed with the result on their left, as the classifiers
+// return them. Counter-clockwise rings are outer rings and clockwise ones
+// holes, each hole attached to the smallest outer ring around it. Gives no
+// polygons once the operation of the calling thread is canceled.
+QVector<InputPolygon> stitchSegments(const QVector<QVector<QPointF>>& segments, double epsSnap = 1e-3);
+
+// A polygon prepared once for clipping many others against it, as side A:
+// topology, edges with their self cuts, the candidate index of the index
+// modes and the point locator. Nothing changes it after construction, so
+// engines on any number of threads can run against one instance.
+class PreparedPolygon {
+public:
+    explicit PreparedPolygon(const InputPolygon& poly, double epsGeom = 1e-3, double epsParam = 1e-3,
+                             const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+
+    double epsGeom() const noexcept { return edges_.epsGeom; }
+    double epsParam() const noexcept { return edges_.epsParam; }
+    const Geometry::AtomizeOptions& options() const noexcept { return opts_; }
+
+private:
+    friend class Engine;
+
+    Geometry::PolygonTopo    topo_;
+    QVector<char>            turned_; // as PrepContext::turnedA
+    Geometry::PreparedEdges  edges_;
+    Geometry::EdgeIndex      index_; // empty unless opts_.mode is an index mode
+    PointLocator             loc_;
+    Geometry::AtomizeOptions opts_;
+};
+
+// Runs prepare() and the classifiers on storage that lives as long as the
+// engine. Inputs are only read during a call; results go to caller storage
+// that is cleared, not freed. Once the buffers have grown to the job sizes,
+// repeated operations reuse their capacity instead of allocating it again.
+// Not thread-safe, use one engine per thread.
+class Engine {
+public:
+    const PrepContext& prepare(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom = 1e-3, double epsParam = 1e-3,
+                               const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+    // the atoms op keeps on the last prepared pair
+    void classify(Operation op, QVector<Geometry::AtomicSegment>& out);
+    // prepare() and classify() in one call
+    void run(Operation op, const InputPolygon& polyA, const InputPolygon& polyB, QVector<Geometry::AtomicSegment>& out,
+             double epsGeom = 1e-3, double epsParam = 1e-3, const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+
+    // the same on topologies built elsewhere, e.g. by PolygonFileView::toTopo,
+    // outer loop first and holes flagged; they are only read
+    const PrepContext& prepare(const Geometry::PolygonTopo& topoA, const Geometry::PolygonTopo& topoB, double epsGeom = 1e-3,
+                               double epsParam = 1e-3, const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+    void run(Operation op, const Geometry::PolygonTopo& topoA, const Geometry::PolygonTopo& topoB, QVector<Geometry::AtomicSegment>& out,
+             double epsGeom = 1e-3, double epsParam = 1e-3, const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+
+    // A from a prepared polygon, which is only read; eps, mode and simpleA are
+    // the ones it was prepared with, simpleB and threads come from opts
+    const PrepContext& prepare(const PreparedPolygon& polyA, const InputPolygon& polyB,
+                               const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+    void run(Operation op, const PreparedPolygon& polyA, const InputPolygon& polyB, QVector<Geometry::AtomicSegment>& out,
+             const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+
+    const PrepContext& context() const noexcept { return ctx_; }
+    void setClassifyMode(ClassifyMode mode) noexcept { ctx_.classifyMode = mode; }
+
+private:
+    PrepContext              ctx_;
+    Geometry::AtomizeBuffers buffers_;
+    QVector<AtomStatus>      status_;
+};
+
+// Holds the last prepared pair, so switching operations on unchanged inputs
+// reuses the atomization. Keyed by the polygon versions plus the parameters
+// that change the atoms; versions are unique across polygons and travel with
+// copies, so a copy of an input hits the cache as well.
+class PrepCache {
+public:
+    const PrepContext& get(const InputPolygon& polyA, const InputPolygon& polyB, double epsGeom, double epsParam,
+                           const Geometry::AtomizeOptions& opts = Geometry::AtomizeOptions());
+    void invalidate() noexcept;
+    bool lastWasHit() const noexcept { return lastHit_; }
+
+private:
+    struct Key {
+        quint64 versionA = 0;
+        quint64 versionB = 0;
+        double epsGeom  = 0.0;
+        double epsParam = 0.0;
+        Geometry::IntersectMode mode = Geometry::IntersectMode::BruteForce;
+        bool simpleA = false;
+        bool simpleB = false;
+        bool operator==(const Key& o) const = default;
+    };
+
+    bool        valid_   = false;
+    bool        lastHit_ = false;
+    Key         key_;
+    PrepContext ctx_;
+};
+
 }
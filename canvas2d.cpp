@@ -2,7 +2,10 @@
 #include <QtMath>
 #include <cmath>
 #include <algorithm>
+#include <utility>
 #include <QDebug>
+#include <QHash>
+#include <QSet>
 
 static inline double absmax4(double a, double b, double c, double d) {
     double m = std::fabs(a);
@@ -21,6 +24,9 @@ Canvas2D::Canvas2D(QWidget* parent)
 
 Canvas2D::~Canvas2D() {
     makeCurrent();
+    for (LineLayer* layer : { &layerA_, &layerB_, &layerRes_, &layerGrid_, &layerAxes_ }) {
+        destroyLayer(*layer);
+    }
     if (program_) {
         glDeleteProgram(program_);
         program_ = 0;
@@ -31,36 +37,49 @@ Canvas2D::~Canvas2D() {
 
 void Canvas2D::setPolygonA(const QVector<QVector<QPointF>>& loops) {
     polyA_ = loops;
+    layerA_.dirty = true;
     recomputeViewRange();
     update();
 }
 
 void Canvas2D::clearPolygonA() {
     polyA_.clear();
+    layerA_.dirty = true;
     recomputeViewRange();
     update();
 }
 
 void Canvas2D::setPolygonB(const QVector<QVector<QPointF>>& loops) {
     polyB_ = loops;
+    layerB_.dirty = true;
     recomputeViewRange();
     update();
 }
 
 void Canvas2D::clearPolygonB() {
     polyB_.clear();
+    layerB_.dirty = true;
     recomputeViewRange();
     update();
 }
 
 void Canvas2D::setResultSegments(const QVector<QVector<QPointF>>& segs) {
     polyRes_ = segs;
+    layerRes_.dirty = true;
+    recomputeViewRange();
+    update();
+}
+
+void Canvas2D::setResultSegments(QVector<QVector<QPointF>>&& segs) {
+    polyRes_ = std::move(segs);
+    layerRes_.dirty = true;
     recomputeViewRange();
     update();
 }
 
 void Canvas2D::clearResultSegments() {
     polyRes_.clear();
+    layerRes_.dirty = true;
     recomputeViewRange();
     update();
 }
@@ -69,6 +88,10 @@ void Canvas2D::clearAll() {
     polyA_.clear();
     polyB_.clear();
     polyRes_.clear();
+    layerA_.dirty   = true;
+    layerB_.dirty   = true;
+    layerRes_.dirty = true;
+    followData_     = true; // nothing left to look at, the next data is fitted
     recomputeViewRange();
     update();
 }
@@ -112,6 +135,11 @@ void Canvas2D::recomputeViewRange() {
 
     if (!hasA && !hasB && !hasR) {
         halfExtent_ = 2.0;
+        if (followData_) {
+            viewCenter_ = QPointF(0.0, 0.0);
+            viewHalf_   = halfExtent_;
+            updateViewExtent(width(), height());
+        }
         return;
     }
 
@@ -155,6 +183,11 @@ void Canvas2D::recomputeViewRange() {
     double candidate = std::max(minHalf, maxAbs * padding);
 
     halfExtent_ = candidate;
+    if (followData_) {
+        viewCenter_ = QPointF(0.0, 0.0);
+        viewHalf_   = halfExtent_;
+        updateViewExtent(width(), height());
+    }
 }
 
 
@@ -194,17 +227,21 @@ void Canvas2D::initializeGL() {
     loc_color_ = glGetUniformLocation(program_, "u_color");
     loc_pos_   = 0; // layout(location=0)
 
+    // a new context starts without buffers, every layer is uploaded again
+    for (LineLayer* layer : { &layerA_, &layerB_, &layerRes_, &layerGrid_, &layerAxes_ }) {
+        *layer = LineLayer();
+    }
+    gridHalf_ = -1.0;
+
     recomputeViewRange();
-    updateViewportAndMVP(width(), height());
+    updateViewExtent(width(), height());
 }
 
 void Canvas2D::resizeGL(int w, int h) {
-    updateViewportAndMVP(w, h);
+    updateViewExtent(w, h);
 }
 
 void Canvas2D::paintGL() {
-    updateViewportAndMVP(width(), height());
-
     const float dpr = float(devicePixelRatioF());
     const int fbW = int(width()  * dpr);
     const int fbH = int(height() * dpr);
@@ -216,11 +253,27 @@ void Canvas2D::paintGL() {
                  1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    const QRectF view = visibleWorldRect();
+    const bool gridCovers = gridHalf_ > 0.0 &&
+                            viewHalfX_ <= 2.0 * gridHalf_ && 2.0 * viewHalfX_ >= gridHalf_ &&
+                            view.left()  >= gridRect_.left()  && view.right()  <= gridRect_.right() &&
+                            view.top()   >= gridRect_.top()   && view.bottom() <= gridRect_.bottom();
+    if (!gridCovers) rebuildGridAndAxes();
+    if (layerA_.dirty)   uploadLoops(layerA_,   polyA_,   /*closed=*/true);
+    if (layerB_.dirty)   uploadLoops(layerB_,   polyB_,   /*closed=*/true);
+    if (layerRes_.dirty) uploadLoops(layerRes_, polyRes_, /*closed=*/false);
+
     glUseProgram(program_);
-    glUniformMatrix4fv(loc_mvp_, 1, GL_FALSE, mvp_.constData());
+
+    const QVector4D gridColor(220.0f/255.0f,
+                              220.0f/255.0f,
+                              220.0f/255.0f,
+                              1.0f);
+    const QVector4D axisColor(0.0f, 0.0f, 0.0f, 1.0f);
 
     glLineWidth(axisWidth_);
-    drawGridAndAxes();
+    drawLayer(layerGrid_, gridColor);
+    drawLayer(layerAxes_, axisColor);
 
     glLineWidth(polyWidth_);
 
@@ -228,17 +281,9 @@ void Canvas2D::paintGL() {
     const QVector4D green (0.0f,   0.63f,  0.0f,   1.0f); // B
     const QVector4D yellow(1.0f,   1.0f,   0.0f,   1.0f); // Result
 
-    for (const auto& loop : polyA_) {
-        drawPolyline(loop, /*closed=*/true, red);
-    }
-
-    for (const auto& loop : polyB_) {
-        drawPolyline(loop, /*closed=*/true, green);
-    }
-
-    for (const auto& seg : polyRes_) {
-        drawPolyline(seg, /*closed=*/false, yellow);
-    }
+    drawLayer(layerA_,   red);
+    drawLayer(layerB_,   green);
+    drawLayer(layerRes_, yellow);
 
     glLineWidth(axisWidth_);
 }
@@ -282,8 +327,8 @@ GLuint Canvas2D::linkProgram(GLuint vs, GLuint fs) {
     return prog;
 }
 
-void Canvas2D::updateViewportAndMVP(int w, int h) {
-    double he = halfExtent_;
+void Canvas2D::updateViewExtent(int w, int h) {
+    double he = viewHalf_;
     if (he < 1e-6) he = 1.0;
 
     double aspect = (h > 0) ? double(w) / double(h) : 1.0;
@@ -296,141 +341,405 @@ void Canvas2D::updateViewportAndMVP(int w, int h) {
         viewHalfY_ = he / aspect;
     }
 
-    mvp_.setToIdentity();
-    mvp_.ortho(
-        float(-viewHalfX_), float(viewHalfX_),
-        float(-viewHalfY_), float(viewHalfY_),
-        -1.0f, 1.0f
-        );
 }
 
-void Canvas2D::drawSegment(const QPointF& a,
-                           const QPointF& b,
-                           const QVector4D& rgba)
+QMatrix4x4 Canvas2D::layerMvp(const LineLayer& layer) const {
+    // the view centre relative to the layer origin in double, so only small
+    // numbers reach the float matrix however far the data is from (0, 0)
+    const double cx = viewCenter_.x() - layer.origin.x();
+    const double cy = viewCenter_.y() - layer.origin.y();
+    QMatrix4x4 mvp;
+    mvp.ortho(float(cx - viewHalfX_), float(cx + viewHalfX_),
+              float(cy - viewHalfY_), float(cy + viewHalfY_),
+              -1.0f, 1.0f);
+    return mvp;
+}
+
+void Canvas2D::uploadLayer(LineLayer& layer,
+                           const QVector<GLfloat>& verts,
+                           const QVector<GLuint>& segments,
+                           bool detailed)
 {
-    GLfloat verts[4] = {
-        GLfloat(a.x()), GLfloat(a.y()),
-        GLfloat(b.x()), GLfloat(b.y())
-    };
+    QVector<GLuint> indices;
+    if (detailed) {
+        buildLevels(layer, verts, segments, indices);
+    } else {
+        LodLevel whole;
+        whole.count = GLsizei(segments.size());
+        layer.levels = { whole };
+        indices = segments;
+    }
 
-    glUniform4f(loc_color_, rgba.x(), rgba.y(), rgba.z(), rgba.w());
+    if (!layer.vao) {
+        glGenVertexArrays(1, &layer.vao);
+        glGenBuffers(1, &layer.vbo);
+        glGenBuffers(1, &layer.ebo);
+
+        // the attribute layout and the index buffer binding live in the VAO
+        glBindVertexArray(layer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, layer.vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layer.ebo);
+        glEnableVertexAttribArray(GLuint(loc_pos_));
+        glVertexAttribPointer(GLuint(loc_pos_), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    } else {
+        glBindVertexArray(layer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, layer.vbo);
+    }
 
-    GLuint vbo = 0;
-    glGenBuffers(1, &vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 verts.size() * sizeof(GLfloat),
+                 verts.constData(),
+                 GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 indices.size() * sizeof(GLuint),
+                 indices.constData(),
+                 GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glEnableVertexAttribArray(GLuint(loc_pos_));
-    glVertexAttribPointer(GLuint(loc_pos_), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    layer.indexCount = GLsizei(indices.size());
+    layer.dirty      = false;
+}
 
-    glDrawArrays(GL_LINES, 0, 2);
+void Canvas2D::buildLevels(LineLayer& layer,
+                           const QVector<GLfloat>& verts,
+                           const QVector<GLuint>& segments,
+                           QVector<GLuint>& indices)
+{
+    layer.levels.clear();
+    indices.resize(0);
+    if (segments.isEmpty()) return;
+
+    double minx = verts[0], maxx = verts[0];
+    double miny = verts[1], maxy = verts[1];
+    for (int v = 0; v < verts.size(); v += 2) {
+        minx = std::min(minx, double(verts[v]));
+        maxx = std::max(maxx, double(verts[v]));
+        miny = std::min(miny, double(verts[v+1]));
+        maxy = std::max(maxy, double(verts[v+1]));
+    }
+    layer.bounds = QRectF(QPointF(minx, miny), QPointF(maxx, maxy));
+    layer.tileW  = std::max(maxx - minx, 1e-9) / kTiles;
+    layer.tileH  = std::max(maxy - miny, 1e-9) / kTiles;
 
-    glDisableVertexAttribArray(GLuint(loc_pos_));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDeleteBuffers(1, &vbo);
+    // tile of grid g, grid 0 the finest; the grids are stored one after the other
+    auto tileX = [&](double x, int g) {
+        return std::clamp(int((x - minx) / layer.tileW), 0, kTiles - 1) >> g;
+    };
+    auto tileY = [&](double y, int g) {
+        return std::clamp(int((y - miny) / layer.tileH), 0, kTiles - 1) >> g;
+    };
+    int tileCount = 0;
+    for (int g = 0; g < kTileGrids; ++g) tileCount += (kTiles >> g) * (kTiles >> g);
+
+    // appends one level, its segments grouped per tile with a counting sort
+    QVector<int> runOf;
+    auto appendLevel = [&](const QVector<GLuint>& segs, double cell) {
+        LodLevel lv;
+        lv.cell  = cell;
+        lv.first = GLsizei(indices.size());
+        lv.count = GLsizei(segs.size());
+        lv.tileStart.fill(0, tileCount + 1);
+        runOf.resize(segs.size() / 2);
+        for (int k = 0; k < segs.size(); k += 2) {
+            const GLfloat* a = verts.constData() + 2 * segs[k];
+            const GLfloat* b = verts.constData() + 2 * segs[k+1];
+            const double x0 = std::min(a[0], b[0]);
+            const double x1 = std::max(a[0], b[0]);
+            const double y0 = std::min(a[1], b[1]);
+            const double y1 = std::max(a[1], b[1]);
+            int g = 0;
+            int offset = 0;
+            while (g + 1 < kTileGrids &&
+                   (tileX(x1, g) - tileX(x0, g) > 1 || tileY(y1, g) - tileY(y0, g) > 1)) {
+                offset += (kTiles >> g) * (kTiles >> g);
+                ++g;
+            }
+            const int run = offset + tileY(y0, g) * (kTiles >> g) + tileX(x0, g);
+            runOf[k / 2] = run;
+            lv.tileStart[run + 1] += 2;
+        }
+        for (int r = 0; r < tileCount; ++r) lv.tileStart[r + 1] += lv.tileStart[r];
+        indices.resize(lv.first + segs.size());
+        QVector<GLsizei> cursor = lv.tileStart;
+        for (int k = 0; k < segs.size(); k += 2) {
+            const GLsizei slot = lv.first + cursor[runOf[k / 2]];
+            cursor[runOf[k / 2]] += 2;
+            indices[slot]     = segs[k];
+            indices[slot + 1] = segs[k+1];
+        }
+        layer.levels.push_back(lv);
+    };
+    appendLevel(segments, 0.0);
+
+    // Coarser levels cluster the vertices of the last kept level on cells that
+    // double in size, so each level nests in the previous one. A level is kept
+    // when it drops at least a quarter of the segments; below a few thousand
+    // segments the full level is cheap enough.
+    const double extent = std::max(maxx - minx, maxy - miny);
+    QVector<GLuint> prev = segments;
+    QVector<GLuint> next;
+    QHash<quint64, GLuint> reps;
+    QSet<quint64> seen;
+    for (double cell = extent / 8192.0; cell > 0.0 && cell < extent && prev.size() > 4096; cell *= 2.0) {
+        reps.clear();
+        seen.clear();
+        next.resize(0);
+        auto repOf = [&](GLuint v) {
+            const quint64 cx = quint64((verts[2 * v]     - minx) / cell);
+            const quint64 cy = quint64((verts[2 * v + 1] - miny) / cell);
+            auto it = reps.find((cx << 32) | cy);
+            if (it == reps.end()) it = reps.insert((cx << 32) | cy, v);
+            return it.value();
+        };
+        for (int k = 0; k < prev.size(); k += 2) {
+            const GLuint a = repOf(prev[k]);
+            const GLuint b = repOf(prev[k+1]);
+            if (a == b) continue;
+            const quint64 key = (quint64(std::min(a, b)) << 32) | std::max(a, b);
+            if (seen.contains(key)) continue;
+            seen.insert(key);
+            next.push_back(a);
+            next.push_back(b);
+        }
+        if (next.size() > prev.size() * 3 / 4) continue;
+        appendLevel(next, cell);
+        prev.swap(next);
+    }
 }
 
-void Canvas2D::drawPolyline(const QVector<QPointF>& pts,
-                            bool closed,
-                            const QVector4D& rgba)
+void Canvas2D::uploadLoops(LineLayer& layer,
+                           const QVector<QVector<QPointF>>& loops,
+                           bool closed)
 {
-    if (pts.size() < 2) return;
+    qsizetype pointCount = 0;
+    for (const auto& pts : loops) pointCount += pts.size();
+
+    QRectF bbox;
+    layer.origin = computeLoopsBBox(loops, bbox) ? bbox.center() : QPointF(0.0, 0.0);
+    const double ox = layer.origin.x();
+    const double oy = layer.origin.y();
+
+    QVector<GLfloat> verts;
+    QVector<GLuint>  segments;
+    verts.reserve(pointCount * 2);
+    segments.reserve(pointCount * 2);
+
+    // closed loops as GL_LINE_LOOP would draw them, open ones as GL_LINE_STRIP
+    for (const auto& pts : loops) {
+        const int n = pts.size();
+        if (n < 2) continue;
+        const GLuint base = GLuint(verts.size() / 2);
+        for (const QPointF& p : pts) {
+            verts.push_back(GLfloat(p.x() - ox));
+            verts.push_back(GLfloat(p.y() - oy));
+        }
+        const int segCount = closed ? n : n - 1;
+        for (int i = 0; i < segCount; ++i) {
+            segments.push_back(base + GLuint(i));
+            segments.push_back(base + GLuint((i + 1) % n));
+        }
+    }
 
-    GLenum mode = closed ? GL_LINE_LOOP : GL_LINE_STRIP;
+    uploadLayer(layer, verts, segments, /*detailed=*/true);
+}
+
+void Canvas2D::destroyLayer(LineLayer& layer) {
+    if (layer.vao) {
+        glDeleteVertexArrays(1, &layer.vao);
+        glDeleteBuffers(1, &layer.vbo);
+        glDeleteBuffers(1, &layer.ebo);
+    }
+    layer = LineLayer();
+}
+
+void Canvas2D::drawLayer(const LineLayer& layer, const QVector4D& rgba) {
+    if (layer.indexCount == 0) return;
 
-    QVector<GLfloat> buf;
-    buf.reserve(pts.size() * 2);
-    for (const QPointF& p : pts) {
-        buf.push_back(GLfloat(p.x()));
-        buf.push_back(GLfloat(p.y()));
+    // coarsest level whose cells stay within one device pixel
+    const double pixel = 2.0 * viewHalfX_ / std::max(1.0, width() * devicePixelRatioF());
+    const LodLevel* lv = &layer.levels.first();
+    for (const LodLevel& l : layer.levels) {
+        if (l.cell <= pixel) lv = &l;
     }
 
+    const QMatrix4x4 mvp = layerMvp(layer);
+    glUniformMatrix4fv(loc_mvp_, 1, GL_FALSE, mvp.constData());
     glUniform4f(loc_color_, rgba.x(), rgba.y(), rgba.z(), rgba.w());
+    glBindVertexArray(layer.vao);
+
+    // runs that touch are merged, a fully visible layer is a single draw
+    GLsizei runBegin = 0;
+    GLsizei runEnd   = 0;
+    auto flush = [&]() {
+        if (runEnd > runBegin) {
+            glDrawElements(GL_LINES, runEnd - runBegin, GL_UNSIGNED_INT,
+                           (void*)(sizeof(GLuint) * size_t(lv->first + runBegin)));
+        }
+        runBegin = runEnd = 0;
+    };
+    auto addRun = [&](GLsizei begin, GLsizei end) {
+        if (end <= begin) return;
+        if (begin != runEnd) flush();
+        if (runEnd == 0) runBegin = begin;
+        runEnd = end;
+    };
 
-    GLuint vbo = 0;
-    glGenBuffers(1, &vbo);
+    if (lv->tileStart.isEmpty()) {
+        addRun(0, lv->count);
+    } else {
+        // a segment sits in the tile of its lower-left corner and reaches at
+        // most one tile further, so each range starts one tile early
+        const QRectF view = visibleWorldRect().translated(-layer.origin);
+        const QRectF& b   = layer.bounds;
+        int offset = 0;
+        for (int g = 0; g < kTileGrids; ++g) {
+            const int side     = kTiles >> g;
+            const double tileW = layer.tileW * (1 << g);
+            const double tileH = layer.tileH * (1 << g);
+            const double fx0 = std::floor((view.left()   - b.left()) / tileW) - 1.0;
+            const double fx1 = std::floor((view.right()  - b.left()) / tileW);
+            const double fy0 = std::floor((view.top()    - b.top())  / tileH) - 1.0;
+            const double fy1 = std::floor((view.bottom() - b.top())  / tileH);
+            if (fx1 >= 0.0 && fy1 >= 0.0 && fx0 < side && fy0 < side) {
+                const int tx0 = int(std::max(fx0, 0.0));
+                const int tx1 = int(std::min(fx1, side - 1.0));
+                const int ty0 = int(std::max(fy0, 0.0));
+                const int ty1 = int(std::min(fy1, side - 1.0));
+                for (int ty = ty0; ty <= ty1; ++ty) {
+                    addRun(lv->tileStart[offset + ty * side + tx0], lv->tileStart[offset + ty * side + tx1 + 1]);
+                }
+            }
+            offset += side * side;
+        }
+    }
+    flush();
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 buf.size() * sizeof(GLfloat),
-                 buf.constData(),
-                 GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
 
-    glEnableVertexAttribArray(GLuint(loc_pos_));
-    glVertexAttribPointer(GLuint(loc_pos_), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+QRectF Canvas2D::visibleWorldRect() const {
+    return QRectF(viewCenter_.x() - viewHalfX_, viewCenter_.y() - viewHalfY_, 2.0 * viewHalfX_, 2.0 * viewHalfY_);
+}
 
-    glDrawArrays(mode, 0, GLsizei(pts.size()));
+QPointF Canvas2D::screenToWorld(const QPointF& pos) const {
+    const double w = std::max(1, width());
+    const double h = std::max(1, height());
+    return QPointF(viewCenter_.x() + (2.0 * pos.x() / w - 1.0) * viewHalfX_,
+                   viewCenter_.y() + (1.0 - 2.0 * pos.y() / h) * viewHalfY_);
+}
 
-    glDisableVertexAttribArray(GLuint(loc_pos_));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDeleteBuffers(1, &vbo);
+void Canvas2D::wheelEvent(QWheelEvent* event) {
+    const double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0.0) return;
+
+    // the world point under the cursor stays where it is
+    const QPointF anchor = screenToWorld(event->position());
+    const double newHalf = std::clamp(viewHalf_ * std::pow(1.25, -steps), 1e-6, 1e12);
+    const double k = newHalf / viewHalf_;
+    viewHalf_   = newHalf;
+    viewCenter_ = QPointF(anchor.x() + (viewCenter_.x() - anchor.x()) * k,
+                          anchor.y() + (viewCenter_.y() - anchor.y()) * k);
+    followData_ = false;
+    updateViewExtent(width(), height());
+    update();
+    event->accept();
 }
 
-void Canvas2D::drawGridAndAxes() {
-    const QVector4D gridColor(220.0f/255.0f,
-                              220.0f/255.0f,
-                              220.0f/255.0f,
-                              1.0f);
-    const QVector4D axisColor(0.0f, 0.0f, 0.0f, 1.0f);
+void Canvas2D::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    dragging_  = true;
+    lastMouse_ = event->position();
+    event->accept();
+}
+
+void Canvas2D::mouseMoveEvent(QMouseEvent* event) {
+    if (!dragging_) return;
+    const QPointF d = event->position() - lastMouse_;
+    lastMouse_ = event->position();
+    const double w = std::max(1, width());
+    const double h = std::max(1, height());
+    viewCenter_ = QPointF(viewCenter_.x() - d.x() * 2.0 * viewHalfX_ / w,
+                          viewCenter_.y() + d.y() * 2.0 * viewHalfY_ / h);
+    followData_ = false;
+    updateViewExtent(width(), height());
+    update();
+    event->accept();
+}
+
+void Canvas2D::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) dragging_ = false;
+}
 
+void Canvas2D::mouseDoubleClickEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    followData_ = true;
+    recomputeViewRange();
+    update();
+}
+
+void Canvas2D::rebuildGridAndAxes() {
+    // three view sizes around the centre, so small pans reuse the layers
     const double hx = viewHalfX_;
     const double hy = viewHalfY_;
+    const double cx = viewCenter_.x();
+    const double cy = viewCenter_.y();
+    gridRect_ = QRectF(cx - 3.0 * hx, cy - 3.0 * hy, 6.0 * hx, 6.0 * hy);
+    gridHalf_ = hx;
+    const double left   = gridRect_.left();
+    const double right  = gridRect_.right();
+    const double bottom = gridRect_.top();
+    const double top    = gridRect_.bottom();
+    layerGrid_.origin = QPointF(cx, cy);
+    layerAxes_.origin = QPointF(cx, cy);
+
+    QVector<GLfloat> gridVerts, axisVerts;
+    QVector<GLuint>  gridIdx,   axisIdx;
+    auto addSegment = [&](QVector<GLfloat>& verts, QVector<GLuint>& idx,
+                          const QPointF& a, const QPointF& b) {
+        const GLuint base = GLuint(verts.size() / 2);
+        verts.push_back(GLfloat(a.x() - cx));
+        verts.push_back(GLfloat(a.y() - cy));
+        verts.push_back(GLfloat(b.x() - cx));
+        verts.push_back(GLfloat(b.y() - cy));
+        idx.push_back(base);
+        idx.push_back(base + 1);
+    };
+    auto gridSegment = [&](const QPointF& a, const QPointF& b) { addSegment(gridVerts, gridIdx, a, b); };
+    auto axisSegment = [&](const QPointF& a, const QPointF& b) { addSegment(axisVerts, axisIdx, a, b); };
 
-    const int minTickX = int(std::floor(-hx));
-    const int maxTickX = int(std::ceil( hx));
-    const int minTickY = int(std::floor(-hy));
-    const int maxTickY = int(std::ceil( hy));
+    // unit grid while at most 200 lines are visible per direction
+    const bool tooDense = (2.0 * hx + 1.0 > 200.0 || 2.0 * hy + 1.0 > 200.0);
 
-    const int spanX = maxTickX - minTickX + 1;
-    const int spanY = maxTickY - minTickY + 1;
-    const bool tooDense = (spanX > 200 || spanY > 200);
+    axisSegment(QPointF(left, 0.0), QPointF(right, 0.0));
+    axisSegment(QPointF(0.0, bottom), QPointF(0.0, top));
 
+    const double tickLen = 0.07;
     if (tooDense) {
-        drawSegment(QPointF(-hx, 0.0), QPointF(hx, 0.0), axisColor);
-        drawSegment(QPointF(0.0,-hy), QPointF(0.0, hy), axisColor);
-
-        const double tickLen = 0.07;
         int tickLimit = 10;
         for (int i = -tickLimit; i <= tickLimit; ++i) {
             double t = double(i);
-            drawSegment(QPointF(t, -tickLen),
-                        QPointF(t,  tickLen),
-                        axisColor);
-            drawSegment(QPointF(-tickLen, t),
-                        QPointF( tickLen, t),
-                        axisColor);
+            axisSegment(QPointF(t, -tickLen),
+                        QPointF(t,  tickLen));
+            axisSegment(QPointF(-tickLen, t),
+                        QPointF( tickLen, t));
+        }
+    } else {
+        for (double gx = std::floor(left); gx <= std::ceil(right); gx += 1.0) {
+            gridSegment(QPointF(gx, bottom),
+                        QPointF(gx, top));
+            axisSegment(QPointF(gx, -tickLen),
+                        QPointF(gx,  tickLen));
+        }
+        for (double gy = std::floor(bottom); gy <= std::ceil(top); gy += 1.0) {
+            gridSegment(QPointF(left,  gy),
+                        QPointF(right, gy));
+            axisSegment(QPointF(-tickLen, gy),
+                        QPointF( tickLen, gy));
         }
-        return;
-    }
-
-    for (int gx = minTickX; gx <= maxTickX; ++gx) {
-        drawSegment(QPointF(gx, -hy),
-                    QPointF(gx,  hy),
-                    gridColor);
-    }
-    for (int gy = minTickY; gy <= maxTickY; ++gy) {
-        drawSegment(QPointF(-hx, gy),
-                    QPointF( hx, gy),
-                    gridColor);
     }
 
-    drawSegment(QPointF(-hx, 0.0),
-                QPointF( hx, 0.0),
-                axisColor);
-    drawSegment(QPointF(0.0,-hy),
-                QPointF(0.0, hy),
-                axisColor);
-
-    const double tickLen = 0.07;
-    for (int gx = minTickX; gx <= maxTickX; ++gx) {
-        drawSegment(QPointF(gx, -tickLen),
-                    QPointF(gx,  tickLen),
-                    axisColor);
-    }
-    for (int gy = minTickY; gy <= maxTickY; ++gy) {
-        drawSegment(QPointF(-tickLen, gy),
-                    QPointF( tickLen, gy),
-                    axisColor);
-    }
+    uploadLayer(layerGrid_, gridVerts, gridIdx, /*detailed=*/false);
+    uploadLayer(layerAxes_, axisVerts, axisIdx, /*detailed=*/false);
 }
@@ -1,12 +1,14 @@
 #pragma once
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
+#include <QMouseEvent>
+#include <QWheelEvent>
 #include <QMatrix4x4>
 #include <QVector>
 #include <QPointF>
 #include <QRectF>
 
-class Canvas2D : public QOpenGLWidget, protected QOpenGLFunctions
+class Canvas2D : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 public:
@@ -20,6 +22,7 @@ public:
     void clearPolygonB();
 
     void setResultSegments(const QVector<QVector<QPointF>>& segs);
+    void setResultSegments(QVector<QVector<QPointF>>&& segs); // takes the result of a worker job
     void clearResultSegments();
 
     void clearAll();
@@ -29,6 +32,13 @@ protected:
     void resizeGL(int w, int h) override;
     void paintGL() override;
 
+    // wheel zooms about the cursor, left drag pans, double click fits the data again
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+
 private:
     GLuint program_   = 0;
     GLint  loc_mvp_   = -1;
@@ -38,7 +48,49 @@ private:
     float axisWidth_ = 1.0f;
     float polyWidth_ = 4.0f;
 
-    QMatrix4x4 mvp_;
+    // One detail level of a layer: a run of GL_LINES index pairs in the layer's
+    // index buffer. Level 0 holds every segment; coarser levels merge the
+    // vertices inside one cell of a square grid, keeping the first of them.
+    // Segments are sorted into tiles over the layer bounds, a loose quadtree
+    // of grids from kTiles x kTiles down to 1 x 1: each segment goes to the
+    // finest grid where it spans at most two tiles per axis, in the tile of
+    // its lower-left corner.
+    struct LodLevel {
+        double           cell  = 0.0; // cluster size in world units, 0 on level 0
+        GLsizei          first = 0; // offset in the index buffer
+        GLsizei          count = 0;
+        QVector<GLsizei> tileStart; // run offsets from first, all grids finest first, empty when untiled
+    };
+
+    // One VBO/VAO pair per layer, drawn as indexed GL_LINES. The setters only
+    // mark a layer dirty; paintGL uploads it once and later frames pick a
+    // level and the visible tiles without touching the buffers.
+    struct LineLayer {
+        GLuint  vao        = 0;
+        GLuint  vbo        = 0;
+        GLuint  ebo        = 0;
+        GLsizei indexCount = 0;
+        bool    dirty      = true;
+        QPointF origin; // world point the float vertices are relative to
+        QRectF  bounds; // tile grid, relative to origin
+        double  tileW      = 1.0;
+        double  tileH      = 1.0;
+        QVector<LodLevel> levels;
+    };
+
+    static constexpr int kTiles     = 32;
+    static constexpr int kTileGrids = 6; // 32, 16, ..., 1 tiles per side
+
+    LineLayer layerA_;
+    LineLayer layerB_;
+    LineLayer layerRes_;
+    LineLayer layerGrid_;
+    LineLayer layerAxes_; // axes and ticks
+
+    // world region and view scale the grid layers were built for; they are
+    // rebuilt once the view leaves the region or zooms by more than 2x
+    QRectF gridRect_;
+    double gridHalf_ = -1.0;
 
     QVector<QVector<QPointF>> polyA_;
     QVector<QVector<QPointF>> polyB_;
@@ -48,18 +100,34 @@ private:
     double viewHalfX_  = 2.0;
     double viewHalfY_  = 2.0;
 
+    // The view is centre plus half extent of the shorter side; viewHalfX_/Y_
+    // follow from it and change only when it or the size does. Until the user
+    // zooms or pans it fits the data, new data keeps a zoomed or panned view
+    // until a double click or clearAll().
+    QPointF viewCenter_;
+    double  viewHalf_   = 2.0;
+    bool    followData_ = true;
+    bool    dragging_   = false;
+    QPointF lastMouse_;
+
     void recomputeViewRange();
+    QPointF screenToWorld(const QPointF& pos) const;
 
     static bool computeLoopsBBox(const QVector<QVector<QPointF>>& loops, QRectF& outBBox);
 
     GLuint compileShader(GLenum type, const char* src);
     GLuint linkProgram(GLuint vs, GLuint fs);
 
-    void updateViewportAndMVP(int w, int h);
-
-    void drawSegment(const QPointF& a, const QPointF& b, const QVector4D& rgba);
+    void updateViewExtent(int w, int h);
+    QMatrix4x4 layerMvp(const LineLayer& layer) const;
 
-    void drawPolyline(const QVector<QPointF>& pts, bool closed, const QVector4D& rgba);
+    void uploadLayer(LineLayer& layer, const QVector<GLfloat>& verts, const QVector<GLuint>& segments, bool detailed);
+    static void buildLevels(LineLayer& layer, const QVector<GLfloat>& verts, const QVector<GLuint>& segments,
+                            QVector<GLuint>& indices);
+    void uploadLoops(LineLayer& layer, const QVector<QVector<QPointF>>& loops, bool closed);
+    void destroyLayer(LineLayer& layer);
+    void drawLayer(const LineLayer& layer, const QVector4D& rgba);
+    QRectF visibleWorldRect() const;
 
-    void drawGridAndAxes();
+    void rebuildGridAndAxes();
 };
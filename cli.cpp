@@ -0,0 +1,204 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+#include "inputpolygon.h"
+#include "booleanops.h"
+#include "polygonfile.h"
+#include "batch.h"
+
+enum class BoolOp {
+    Union,
+    Intersection,
+    SubAB,
+    SubBA
+};
+
+static bool parseOp(const QString& name, BoolOp& op) {
+    const QString n = name.toLower();
+    if (n == "union" || n == "addition")  { op = BoolOp::Union;        return true; }
+    if (n == "intersection")              { op = BoolOp::Intersection; return true; }
+    if (n == "a-b" || n == "subab")       { op = BoolOp::SubAB;        return true; }
+    if (n == "b-a" || n == "subba")       { op = BoolOp::SubBA;        return true; }
+    return false;
+}
+
+// polybool-cli convert <in> <out>: any readable polygon file to binary or
+// text; a file of several polygons only converts to text
+static int runConvert(const QString& inPath, const QString& outPath, const QString& format) {
+    QVector<InputPolygon> polys;
+    QString err;
+    if (format == "text") {
+        if (!InputPolygon::loadAll(inPath, polys, &err)) {
+            qCritical().noquote() << "[cli]" << err;
+            return 2;
+        }
+    } else {
+        polys.resize(1);
+        if (!polys[0].loadData(inPath, &err)) {
+            qCritical().noquote() << "[cli]" << err;
+            return 2;
+        }
+    }
+    const bool ok = (format == "text") ? InputPolygon::saveAll(outPath, polys, &err)
+                                       : PolygonFileView::write(outPath, polys[0], &err);
+    if (!ok) {
+        qCritical().noquote() << "[cli]" << err;
+        return 3;
+    }
+    return 0;
+}
+
+// polybool-cli batch <manifest>: every row of the manifest on a worker pool
+static int runBatchManifest(const QString& manifestPath, const Boolean2D::BatchOptions& opts) {
+    QVector<Boolean2D::BatchJob> jobs;
+    QString err;
+    if (!Boolean2D::readManifest(manifestPath, jobs, &err)) {
+        qCritical().noquote() << "[cli]" << err;
+        return 2;
+    }
+    const Boolean2D::BatchSummary summary = Boolean2D::runBatch(jobs, opts);
+    qInfo().noquote() << "[cli] batch:" << summary.summary();
+    return summary.failed > 0 ? 4 : 0;
+}
+
+static bool parseMode(const QString& name, Geometry::IntersectMode& mode) {
+    const QString n = name.toLower();
+    if (n == "brute") { mode = Geometry::IntersectMode::BruteForce; return true; }
+    if (n == "sweep") { mode = Geometry::IntersectMode::SweepLine;  return true; }
+    if (n == "grid")  { mode = Geometry::IntersectMode::GridIndex;  return true; }
+    if (n == "rtree") { mode = Geometry::IntersectMode::RTreeIndex; return true; }
+    return false;
+}
+
+// thread and worker counts, 0 = all cores
+static bool parseCount(const QString& text, int& n) {
+    bool ok = false;
+    n = text.toInt(&ok);
+    return ok && n >= 0;
+}
+
+static bool parseEps(const QString& text, double& eps) {
+    bool ok = false;
+    eps = text.toDouble(&ok);
+    return ok && std::isfinite(eps) && eps > 0.0;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("polybool-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless polygon boolean operations.\n"
+                                     "polybool-cli convert <in> <out> [--format text] converts a polygon file.\n"
+                                     "polybool-cli batch <manifest> [--jobs n] [--report csv] runs every\n"
+                                     "\"fileA fileB op out\" row of a manifest.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("fileA", "Polygon A (text or binary).");
+    parser.addPositionalArgument("fileB", "Polygon B (text or binary).");
+    parser.addPositionalArgument("op", "union | intersection | a-b | b-a");
+    parser.addPositionalArgument("out", "Result file, one \"#polygon\" block per result polygon.");
+    QCommandLineOption modeOpt("mode", "Candidate pairs: brute | sweep | grid | rtree (default rtree).", "mode", "rtree");
+    QCommandLineOption threadsOpt("threads", "Threads for atomization, 0 = all cores (default 1).", "n", "1");
+    QCommandLineOption epsGeomOpt("eps-geom", "Geometric tolerance (default 1e-3).", "eps", "1e-3");
+    QCommandLineOption epsParamOpt("eps-param", "Parametric tolerance (default 1e-9).", "eps", "1e-9");
+    QCommandLineOption propagateOpt("propagate", "Propagate in/out status along atom chains.");
+    QCommandLineOption segmentsOpt("segments", "Write the raw kept segments as open \"#polyline\" blocks instead of stitched rings.");
+    QCommandLineOption statsOpt("stats", "Print per-stage timings and counters.");
+    QCommandLineOption formatOpt("format", "Output format of convert: binary | text (default binary).", "format", "binary");
+    QCommandLineOption jobsOpt("jobs", "Worker threads of batch, 0 = all cores (default 0).", "n", "0");
+    QCommandLineOption reportOpt("report", "CSV with one row per finished batch job.", "file");
+    parser.addOption(modeOpt);
+    parser.addOption(threadsOpt);
+    parser.addOption(epsGeomOpt);
+    parser.addOption(epsParamOpt);
+    parser.addOption(propagateOpt);
+    parser.addOption(segmentsOpt);
+    parser.addOption(statsOpt);
+    parser.addOption(formatOpt);
+    parser.addOption(jobsOpt);
+    parser.addOption(reportOpt);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (!args.isEmpty() && args[0] == "convert") {
+        const QString format = parser.value(formatOpt).toLower();
+        if (args.size() != 3 || (format != "binary" && format != "text")) {
+            parser.showHelp(1);
+        }
+        return runConvert(args[1], args[2], format);
+    }
+    if (!args.isEmpty() && args[0] == "batch") {
+        Boolean2D::BatchOptions batchOpts;
+        if (args.size() != 2 || !parseMode(parser.value(modeOpt), batchOpts.atomize.mode)) {
+            parser.showHelp(1);
+        }
+        if (!parseCount(parser.value(jobsOpt), batchOpts.workers) ||
+            !parseEps(parser.value(epsGeomOpt), batchOpts.epsGeom) ||
+            !parseEps(parser.value(epsParamOpt), batchOpts.epsParam)) {
+            parser.showHelp(1);
+        }
+        batchOpts.propagate  = parser.isSet(propagateOpt);
+        batchOpts.segments   = parser.isSet(segmentsOpt);
+        batchOpts.reportPath = parser.value(reportOpt);
+        return runBatchManifest(args[1], batchOpts);
+    }
+    BoolOp op;
+    Geometry::AtomizeOptions opts;
+    double epsGeom  = 0.0;
+    double epsParam = 0.0;
+    if (args.size() != 4 || !parseOp(args[2], op) || !parseMode(parser.value(modeOpt), opts.mode) ||
+        !parseCount(parser.value(threadsOpt), opts.threads) ||
+        !parseEps(parser.value(epsGeomOpt), epsGeom) || !parseEps(parser.value(epsParamOpt), epsParam)) {
+        parser.showHelp(1);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    InputPolygon polygonA;
+    InputPolygon polygonB;
+    QString err;
+    if (!polygonA.loadData(args[0], &err) || !polygonB.loadData(args[1], &err)) {
+        qCritical().noquote() << "[cli]" << err;
+        return 2;
+    }
+    const qint64 loadMs = timer.restart();
+
+    Geometry::PipelineStats stats;
+    Geometry::StatsScope statsScope(parser.isSet(statsOpt) ? &stats : nullptr);
+    auto ctx = Boolean2D::prepare(polygonA, polygonB, epsGeom, epsParam, opts);
+    if (parser.isSet(propagateOpt)) {
+        ctx.classifyMode = Boolean2D::ClassifyMode::Propagate;
+    }
+    QVector<QVector<QPointF>> segments;
+    switch (op) {
+    case BoolOp::Union:        segments = Boolean2D::computeAdditionSegments(ctx, polygonA, polygonB);      break;
+    case BoolOp::Intersection: segments = Boolean2D::computeIntersectionSegments(ctx, polygonA, polygonB);  break;
+    case BoolOp::SubAB:        segments = Boolean2D::computeSubtractionABSegments(ctx, polygonA, polygonB); break;
+    case BoolOp::SubBA:        segments = Boolean2D::computeSubtractionBASegments(ctx, polygonA, polygonB); break;
+    }
+    const qint64 opMs = timer.restart();
+
+    QVector<InputPolygon> result;
+    bool saved = false;
+    if (parser.isSet(segmentsOpt)) {
+        saved = InputPolygon::savePolylines(args[3], segments, &err);
+    } else {
+        result = Boolean2D::stitchSegments(segments, epsGeom);
+        saved = InputPolygon::saveAll(args[3], result, &err);
+    }
+    if (!saved) {
+        qCritical().noquote() << "[cli]" << err;
+        return 3;
+    }
+    qInfo().noquote() << "[cli]" << args[2] << "atoms:" << ctx.atoms.size()
+                      << "kept segments:" << segments.size()
+                      << "polygons:" << result.size()
+                      << "load ms:" << loadMs << "op ms:" << opMs
+                      << "write ms:" << timer.elapsed();
+    if (parser.isSet(statsOpt)) {
+        qInfo().noquote() << "[cli] stats:" << stats.summary();
+    }
+    return 0;
+}
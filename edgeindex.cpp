@@ -0,0 +1,240 @@
+#include "edgeindex.h"
+#include "pipelinestats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Geometry {
+
+static inline bool boxesOverlap(const EdgeBox& a, const EdgeBox& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX &&
+           a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+static inline bool isBounded(const EdgeBox& b) {
+    return std::isfinite(b.minX) && std::isfinite(b.maxX) &&
+           std::isfinite(b.minY) && std::isfinite(b.maxY);
+}
+
+static inline EdgeBox unionBox(const EdgeBox& a, const EdgeBox& b) {
+    return { std::min(a.minX, b.minX), std::min(a.minY, b.minY),
+             std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+}
+
+EdgeIndex::EdgeIndex(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom, Backend backend) {
+    build(buildEdgeBoxes(poly, edges, epsGeom), backend);
+}
+
+void EdgeIndex::build(const QVector<EdgeBox>& boxes, Backend backend) {
+    backend_ = backend;
+    // copied element-wise so that a rebuild reuses the storage of boxes_
+    boxes_.resize(boxes.size());
+    std::copy(boxes.begin(), boxes.end(), boxes_.begin());
+    unbounded_.clear();
+    cellStart_.clear();
+    cellItems_.clear();
+    nodes_.clear();
+    entries_.clear();
+    gridCols_ = gridRows_ = 0;
+    for (int i = 0; i < boxes_.size(); ++i) {
+        if (!isBounded(boxes_[i])) unbounded_.push_back(i);
+    }
+    if (backend_ == Backend::Grid) buildGrid();
+    else                           buildRTree();
+}
+
+void EdgeIndex::buildGrid() {
+    bool first = true;
+    EdgeBox bounds{0.0, 0.0, 0.0, 0.0};
+    double sumW = 0.0, sumH = 0.0;
+    int n = 0;
+    for (const auto& b : boxes_) {
+        if (!isBounded(b)) continue;
+        bounds = first ? b : unionBox(bounds, b);
+        first = false;
+        sumW += b.maxX - b.minX;
+        sumH += b.maxY - b.minY;
+        ++n;
+    }
+    if (n == 0) return;
+    const double W = bounds.maxX - bounds.minX;
+    const double H = bounds.maxY - bounds.minY;
+    double cs = std::max(sumW, sumH) / n;
+    const double maxCells = 4.0 * n;
+    if (cs <= 0.0 || (W / cs) * (H / cs) > maxCells) {
+        cs = std::sqrt(std::max(W * H, 1e-300) / maxCells);
+    }
+    cs = std::max({ cs, W / maxCells, H / maxCells, 1e-300 });
+    gridMinX_ = bounds.minX;
+    gridMinY_ = bounds.minY;
+    cellSize_ = cs;
+    gridCols_ = std::max(1, int(std::ceil(W / cs)));
+    gridRows_ = std::max(1, int(std::ceil(H / cs)));
+
+    auto cellX = [&](double x) { return std::clamp(int((x - gridMinX_) / cellSize_), 0, gridCols_ - 1); };
+    auto cellY = [&](double y) { return std::clamp(int((y - gridMinY_) / cellSize_), 0, gridRows_ - 1); };
+
+    cellStart_.fill(0, qsizetype(gridCols_) * gridRows_ + 1);
+    for (const auto& b : boxes_) {
+        if (!isBounded(b)) continue;
+        for (int cy = cellY(b.minY); cy <= cellY(b.maxY); ++cy)
+            for (int cx = cellX(b.minX); cx <= cellX(b.maxX); ++cx)
+                ++cellStart_[qsizetype(cy) * gridCols_ + cx + 1];
+    }
+    for (int c = 0; c + 1 < cellStart_.size(); ++c) {
+        cellStart_[c + 1] += cellStart_[c];
+    }
+    QVector<int>& fill = fillScratch_;
+    fill.resize(cellStart_.size());
+    std::copy(cellStart_.begin(), cellStart_.end(), fill.begin());
+    cellItems_.resize(cellStart_.last());
+    for (int i = 0; i < boxes_.size(); ++i) {
+        const auto& b = boxes_[i];
+        if (!isBounded(b)) continue;
+        for (int cy = cellY(b.minY); cy <= cellY(b.maxY); ++cy)
+            for (int cx = cellX(b.minX); cx <= cellX(b.maxX); ++cx)
+                cellItems_[fill[qsizetype(cy) * gridCols_ + cx]++] = i;
+    }
+}
+
+void EdgeIndex::queryGrid(const EdgeBox& box, QVector<int>& out) const {
+    if (gridCols_ == 0) return;
+    auto cellX = [&](double x) { return std::clamp(int((x - gridMinX_) / cellSize_), 0, gridCols_ - 1); };
+    auto cellY = [&](double y) { return std::clamp(int((y - gridMinY_) / cellSize_), 0, gridRows_ - 1); };
+    const double qMinX = std::max(box.minX, gridMinX_ - cellSize_);
+    const double qMinY = std::max(box.minY, gridMinY_ - cellSize_);
+    const double qMaxX = std::min(box.maxX, gridMinX_ + (gridCols_ + 1) * cellSize_);
+    const double qMaxY = std::min(box.maxY, gridMinY_ + (gridRows_ + 1) * cellSize_);
+    if (qMinX > qMaxX || qMinY > qMaxY) return;
+    for (int cy = cellY(qMinY); cy <= cellY(qMaxY); ++cy) {
+        for (int cx = cellX(qMinX); cx <= cellX(qMaxX); ++cx) {
+            const qsizetype c = qsizetype(cy) * gridCols_ + cx;
+            for (int k = cellStart_[c]; k < cellStart_[c + 1]; ++k) {
+                const int id = cellItems_[k];
+                const EdgeBox& b = boxes_[id];
+                if (!boxesOverlap(b, box)) continue;
+                // report each edge once: from the cell holding the overlap's min corner
+                if (cellX(std::max(b.minX, box.minX)) != cx) continue;
+                if (cellY(std::max(b.minY, box.minY)) != cy) continue;
+                out.push_back(id);
+            }
+        }
+    }
+}
+
+void EdgeIndex::buildRTree() {
+    const int M = 16;
+    auto centerX = [](const EdgeBox& b) { return 0.5 * (b.minX + b.maxX); };
+    auto centerY = [](const EdgeBox& b) { return 0.5 * (b.minY + b.maxY); };
+
+    // sort-tile-recursive: slice by x center, then order each slice by y center
+    auto strOrder = [&](auto& items, auto boxOf) {
+        const int n = items.size();
+        const int leafCount = (n + M - 1) / M;
+        const int slices = std::max(1, int(std::ceil(std::sqrt(double(leafCount)))));
+        const int sliceSize = slices * M;
+        std::sort(items.begin(), items.end(), [&](const auto& l, const auto& r) {
+            return centerX(boxOf(l)) < centerX(boxOf(r));
+        });
+        for (int s = 0; s < n; s += sliceSize) {
+            auto end = items.begin() + std::min(n, s + sliceSize);
+            std::sort(items.begin() + s, end, [&](const auto& l, const auto& r) {
+                return centerY(boxOf(l)) < centerY(boxOf(r));
+            });
+        }
+    };
+
+    for (int i = 0; i < boxes_.size(); ++i) {
+        if (isBounded(boxes_[i])) entries_.push_back(i);
+    }
+    if (entries_.isEmpty()) return;
+    strOrder(entries_, [&](int id) -> const EdgeBox& { return boxes_[id]; });
+
+    QVector<Node>& level = levelScratch_;
+    level.clear();
+    for (int s = 0; s < entries_.size(); s += M) {
+        Node nd;
+        nd.first = s;
+        nd.count = std::min<int>(M, entries_.size() - s);
+        nd.leaf  = true;
+        nd.box   = boxes_[entries_[s]];
+        for (int k = 1; k < nd.count; ++k) nd.box = unionBox(nd.box, boxes_[entries_[s + k]]);
+        level.push_back(nd);
+    }
+    while (level.size() > 1) {
+        strOrder(level, [](const Node& nd) -> const EdgeBox& { return nd.box; });
+        const int base = nodes_.size();
+        nodes_ += level;
+        QVector<Node>& parents = parentScratch_;
+        parents.clear();
+        for (int s = 0; s < level.size(); s += M) {
+            Node nd;
+            nd.first = base + s;
+            nd.count = std::min<int>(M, level.size() - s);
+            nd.leaf  = false;
+            nd.box   = level[s].box;
+            for (int k = 1; k < nd.count; ++k) nd.box = unionBox(nd.box, level[s + k].box);
+            parents.push_back(nd);
+        }
+        level.swap(parents);
+    }
+    nodes_.push_back(level.first());
+}
+
+void EdgeIndex::queryRTree(const EdgeBox& box, QVector<int>& out) const {
+    if (nodes_.isEmpty()) return;
+    int stack[256]; // 15 pending siblings per level is far below this for any int-sized tree
+    int top = 0;
+    stack[top++] = nodes_.size() - 1;
+    while (top > 0) {
+        const Node& nd = nodes_[stack[--top]];
+        if (!boxesOverlap(nd.box, box)) continue;
+        if (nd.leaf) {
+            for (int k = nd.first; k < nd.first + nd.count; ++k) {
+                if (boxesOverlap(boxes_[entries_[k]], box)) out.push_back(entries_[k]);
+            }
+        } else {
+            for (int k = nd.first; k < nd.first + nd.count; ++k) stack[top++] = k;
+        }
+    }
+}
+
+void EdgeIndex::query(const EdgeBox& box, QVector<int>& out) const {
+    for (int id : unbounded_) out.push_back(id);
+    if (backend_ == Backend::Grid) queryGrid(box, out);
+    else                           queryRTree(box, out);
+}
+
+QVector<EdgePair> EdgeIndex::candidatePairs(const QVector<EdgeBox>& otherBoxes, QueryStats* stats) const {
+    CandidateBuffers buf;
+    QVector<EdgePair> pairs;
+    candidatePairs(otherBoxes, pairs, buf, stats);
+    return pairs;
+}
+
+void EdgeIndex::candidatePairs(const QVector<EdgeBox>& otherBoxes, QVector<EdgePair>& out, CandidateBuffers& buf,
+                               QueryStats* stats) const {
+    out.clear();
+    QVector<EdgePair>& found = buf.found;
+    QVector<int>& hits = buf.hits;
+    found.clear();
+    for (int j = 0; j < otherBoxes.size(); ++j) {
+        if ((j & 1023) == 0 && cancelRequested()) return;
+        hits.resize(0);
+        query(otherBoxes[j], hits);
+        for (int i : hits) found.push_back({ i, j });
+    }
+    // found is in increasing b, so a counting scatter by a sorts by (a, b)
+    QVector<int>& start = buf.start;
+    start.fill(0, boxes_.size() + 1);
+    for (const auto& pr : found) ++start[pr.a + 1];
+    for (int i = 0; i < boxes_.size(); ++i) start[i + 1] += start[i];
+    out.resize(found.size());
+    for (const auto& pr : found) out[start[pr.a]++] = pr;
+    if (stats) {
+        stats->candidatePairs  += out.size();
+        stats->bruteForcePairs += qint64(boxes_.size()) * otherBoxes.size();
+    }
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <QVector>
+#include <QtGlobal>
+#include "geometrymodel.h"
+
+namespace Geometry {
+
+// Bounding-box index over the edges of one polygon. Queries return every
+// indexed edge whose (padded) box overlaps the query box.
+class EdgeIndex {
+public:
+    enum class Backend {
+        Grid, // uniform grid, cell size from the mean edge extent
+        RTree // STR bulk-loaded R-tree
+    };
+
+    struct QueryStats {
+        qint64 candidatePairs  = 0; // pairs handed to the exact test
+        qint64 bruteForcePairs = 0; // pairs the n * m loop would test
+    };
+
+    EdgeIndex() = default;
+    EdgeIndex(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom, Backend backend = Backend::RTree);
+
+    void build(const QVector<EdgeBox>& boxes, Backend backend);
+
+    void query(const EdgeBox& box, QVector<int>& out) const;
+
+    // pairs (a = indexed edge, b = index in otherBoxes), sorted by (a, b)
+    QVector<EdgePair> candidatePairs(const QVector<EdgeBox>& otherBoxes, QueryStats* stats = nullptr) const;
+    // the same pairs written to out, on the working storage of buf; out may be buf.pairs
+    void candidatePairs(const QVector<EdgeBox>& otherBoxes, QVector<EdgePair>& out, CandidateBuffers& buf,
+                        QueryStats* stats = nullptr) const;
+
+    Backend backend() const noexcept { return backend_; }
+    int size() const noexcept { return int(boxes_.size()); }
+    const QVector<EdgeBox>& boxes() const noexcept { return boxes_; }
+
+private:
+    struct Node {
+        EdgeBox box;
+        int     first; // child node index, or entry index for leaves
+        int     count;
+        bool    leaf;
+    };
+
+    void buildGrid();
+    void buildRTree();
+    void queryGrid(const EdgeBox& box, QVector<int>& out) const;
+    void queryRTree(const EdgeBox& box, QVector<int>& out) const;
+
+    Backend          backend_ = Backend::RTree;
+    QVector<EdgeBox> boxes_;
+    QVector<int>     unbounded_; // degenerate edges, reported for every query
+
+    // grid
+    double       gridMinX_  = 0.0;
+    double       gridMinY_  = 0.0;
+    double       cellSize_  = 1.0;
+    int          gridCols_  = 0;
+    int          gridRows_  = 0;
+    QVector<int> cellStart_; // CSR offsets, gridCols_ * gridRows_ + 1 entries
+    QVector<int> cellItems_;
+
+    // R-tree
+    QVector<Node> nodes_;    // root is the last node
+    QVector<int>  entries_;  // edge ids in leaf order
+
+    // build() temporaries, kept so that rebuilding an index reuses them
+    QVector<int>  fillScratch_;
+    QVector<Node> levelScratch_, parentScratch_;
+};
+
+}
@@ -1,19 +1,20 @@
 #include "geometrymodel.h"
+#include "edgeindex.h"
+#include "pipelinestats.h"
+#include "segmentkernel.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace Geometry {
 
 
-static inline double dot2d(const QPointF& a, const QPointF& b) {
-    return a.x()*b.x() + a.y()*b.y();
-}
-
-static inline double cross2d(const QPointF& a, const QPointF& b) {
-    return a.x()*b.y() - a.y()*b.x();
-}
-
 static inline QPointF lerpPoint(const QPointF& a, const QPointF& b, double t) {
     return QPointF(
         a.x() + (b.x() - a.x()) * t,
@@ -29,32 +30,64 @@ static bool intervalIntersection(double a0, double a1, double b0, double b1, dou
     return (hi >= lo);
 }
 
-static void injectSelfCollinearCuts(const PolygonTopo& poly, const QVector<RawEdge>& rawEdges, QVector<EdgeWork>& work, double epsGeom, double epsParam) {
-    const int m = rawEdges.size();
-    for (int i = 0; i < m; ++i) {
+// the self pass on prepared edge arrays, arr as built by buildEdgeArrays
+static void injectSelfCuts(const QVector<RawEdge>& rawEdges, const EdgeArrays& arr, EdgeWork& work, double epsGeom, double epsParam,
+                           CandidateBuffers& buf) {
+    StageTimer timer(&PipelineStats::selfCutsNs);
+    edgeBoxes(arr, buf.boxesA);
+    sweepSelfCandidatePairs(buf.boxesA, buf.pairs, buf);
+    const QVector<EdgePair>& pairs = buf.pairs;
+    if (PipelineStats* stats = activeStats()) stats->selfPairs += pairs.size();
+    const PipelineStage stage = (rawEdges.isEmpty() || rawEdges[0].fromA) ? PipelineStage::SelfCutsA
+                                                                          : PipelineStage::SelfCutsB;
+    for (int k = 0; k < pairs.size(); ++k) {
+        if ((k & 4095) == 0) {
+            if (cancelRequested()) return;
+            reportProgress(stage, double(k) / pairs.size());
+        }
+        const int i = pairs[k].a;
+        const int j = pairs[k].b;
         const auto& ei = rawEdges[i];
-        const QPointF A0 = poly.verts[ei.vStart].pos;
-        const QPointF A1 = poly.verts[ei.vEnd  ].pos;
-        for (int j = i + 1; j < m; ++j) {
-            const auto& ej = rawEdges[j];
-            const QPointF B0 = poly.verts[ej.vStart].pos;
-            const QPointF B1 = poly.verts[ej.vEnd  ].pos;
-            SegmentIntersection inter = intersectSegments(A0, A1, B0, B1, epsGeom);
-            if (inter.type == IntersectType::Overlap) {
-                work[i].cutParams.push_back(inter.tA0);
-                work[i].cutParams.push_back(inter.tA1);
-                work[j].cutParams.push_back(inter.tB0);
-                work[j].cutParams.push_back(inter.tB1);
-            } else if (inter.type == IntersectType::Point) {
-                work[i].cutParams.push_back(inter.tA);
-                work[j].cutParams.push_back(inter.tB);
-            }
+        const auto& ej = rawEdges[j];
+        SegmentIntersection inter = intersectSegments(arr, i, arr, j, epsGeom);
+        if (inter.type == IntersectType::Overlap) {
+            work.cuts.push_back({ i, IntersectType::Overlap, false, true, false, inter.tA0, inter.tA1 });
+            work.cuts.push_back({ j, IntersectType::Overlap, false, true, false, inter.tB0, inter.tB1 });
+        } else if (inter.type == IntersectType::Point) {
+            // consecutive edges always meet at their shared vertex, that changes nothing
+            const bool sharedVertex =
+                (ei.vEnd == ej.vStart && inter.tA >= 1.0 - epsParam && inter.tB <= epsParam) ||
+                (ej.vEnd == ei.vStart && inter.tB >= 1.0 - epsParam && inter.tA <= epsParam);
+            work.cuts.push_back({ i, IntersectType::Point, false, !sharedVertex, false, inter.tA, inter.tA });
+            work.cuts.push_back({ j, IntersectType::Point, false, !sharedVertex, false, inter.tB, inter.tB });
         }
     }
 }
 
+void injectSelfCollinearCuts(const PolygonTopo& poly, const QVector<RawEdge>& rawEdges, EdgeWork& work, double epsGeom, double epsParam) {
+    EdgeArrays arr;
+    {
+        StageTimer timer(&PipelineStats::selfCutsNs);
+        buildEdgeArrays(poly, rawEdges, epsGeom, arr);
+    }
+    CandidateBuffers cand;
+    injectSelfCuts(rawEdges, arr, work, epsGeom, epsParam, cand);
+}
+
+AtomizeBuffers::AtomizeBuffers() = default;
+AtomizeBuffers::~AtomizeBuffers() = default;
+AtomizeBuffers::AtomizeBuffers(AtomizeBuffers&&) noexcept = default;
+AtomizeBuffers& AtomizeBuffers::operator=(AtomizeBuffers&&) noexcept = default;
+
 QVector<RawEdge> buildRawEdges(const PolygonTopo& poly, bool fromA) {
     QVector<RawEdge> edges;
+    buildRawEdges(poly, fromA, edges);
+    return edges;
+}
+
+void buildRawEdges(const PolygonTopo& poly, bool fromA, QVector<RawEdge>& edges) {
+    StageTimer timer(&PipelineStats::rawEdgesNs);
+    edges.resize(0);
     for (int lid = 0; lid < poly.loops.size(); ++lid) {
         const auto& loop = poly.loops[lid];
         const auto& lv   = loop.loopVertices;
@@ -69,19 +102,341 @@ QVector<RawEdge> buildRawEdges(const PolygonTopo& poly, bool fromA) {
             edges.push_back(e);
         }
     }
-    return edges;
+    if (PipelineStats* stats = activeStats()) stats->rawEdges += edges.size();
 }
 
-SegmentIntersection intersectSegments(const QPointF& A0, const QPointF& A1, const QPointF& B0, const QPointF& B1, double epsGeom) {
+// intersectSegments accepts t in [-eps, 1+eps] (eps * len in distance) and
+// collinear partners up to 2 * eps / len off the line, so pad by both.
+static EdgeBox paddedEdgeBox(double x0, double y0, double x1, double y1, double epsGeom) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double len = std::hypot(x1 - x0, y1 - y0);
+    if (len == 0.0) {
+        return { -inf, -inf, inf, inf }; // degenerate edge, collinear with everything
+    }
+    const double pad = 1.01 * (epsGeom * (1.0 + len) + 2.0 * epsGeom / len);
+    return { std::min(x0, x1) - pad, std::min(y0, y1) - pad,
+             std::max(x0, x1) + pad, std::max(y0, y1) + pad };
+}
+
+QVector<EdgeBox> buildEdgeBoxes(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom) {
+    QVector<EdgeBox> boxes;
+    boxes.reserve(edges.size());
+    for (const auto& e : edges) {
+        const QPointF P0 = poly.verts[e.vStart].pos;
+        const QPointF P1 = poly.verts[e.vEnd  ].pos;
+        boxes.push_back(paddedEdgeBox(P0.x(), P0.y(), P1.x(), P1.y(), epsGeom));
+    }
+    return boxes;
+}
+
+EdgeArrays buildEdgeArrays(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom) {
+    EdgeArrays arr;
+    buildEdgeArrays(poly, edges, epsGeom, arr);
+    return arr;
+}
+
+void buildEdgeArrays(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom, EdgeArrays& arr) {
+    const int n = edges.size();
+    for (QVector<double>* v : { &arr.x0, &arr.y0, &arr.x1, &arr.y1, &arr.dx, &arr.dy,
+                                &arr.minX, &arr.minY, &arr.maxX, &arr.maxY }) {
+        v->resize(n);
+    }
+    for (int i = 0; i < n; ++i) {
+        const QPointF P0 = poly.verts[edges[i].vStart].pos;
+        const QPointF P1 = poly.verts[edges[i].vEnd  ].pos;
+        arr.x0[i] = P0.x();
+        arr.y0[i] = P0.y();
+        arr.x1[i] = P1.x();
+        arr.y1[i] = P1.y();
+        arr.dx[i] = P1.x() - P0.x();
+        arr.dy[i] = P1.y() - P0.y();
+        const EdgeBox b = paddedEdgeBox(P0.x(), P0.y(), P1.x(), P1.y(), epsGeom);
+        arr.minX[i] = b.minX;
+        arr.minY[i] = b.minY;
+        arr.maxX[i] = b.maxX;
+        arr.maxY[i] = b.maxY;
+    }
+}
+
+QVector<EdgeBox> edgeBoxes(const EdgeArrays& arr) {
+    QVector<EdgeBox> boxes(arr.size());
+    for (int i = 0; i < arr.size(); ++i) boxes[i] = arr.box(i);
+    return boxes;
+}
+
+void edgeBoxes(const EdgeArrays& arr, QVector<EdgeBox>& out) {
+    out.resize(arr.size());
+    for (int i = 0; i < arr.size(); ++i) out[i] = arr.box(i);
+}
+
+// YRangeIndex: a range meets the query span [lo, hi] if it contains lo or
+// starts in (lo, hi]. The first kind sits at the canonical nodes of its rank
+// span and is read on the path to lo, the second is counted per node and read
+// at the leaves, so a query costs O(log n + k) however many ranges are
+// active. build() lays out the slots of every range; insert and erase swap it
+// into or out of the active prefix of each slot run.
+void YRangeIndex::build(const QVector<int>& lo, const QVector<int>& hi, int leafCount) {
+    const int n = lo.size();
+    leaves_ = qMax(1, leafCount);
+    // copied element-wise so that no storage is shared with the caller
+    lo_.resize(n);
+    std::copy(lo.begin(), lo.end(), lo_.begin());
+    const int nodes = 4 * leaves_;
+    nodeStart_.fill(0, nodes + 1);
+    nodeActive_.fill(0, nodes);
+    count_.fill(0, nodes);
+    entryStart_.resize(n + 1);
+    entryStart_[0] = 0;
+    for (int id = 0; id < n; ++id) {
+        int k = 0;
+        cover(1, 0, leaves_ - 1, lo[id], hi[id], [&](int node) { ++nodeStart_[node + 1]; ++k; });
+        entryStart_[id + 1] = entryStart_[id] + k;
+    }
+    for (int i = 0; i < nodes; ++i) nodeStart_[i + 1] += nodeStart_[i];
+    const int entries = entryStart_[n];
+    entryNode_.resize(entries);
+    entryOwner_.resize(entries);
+    entrySlot_.resize(entries);
+    slots_.resize(entries);
+    fill_.resize(nodes + 1);
+    std::copy(nodeStart_.begin(), nodeStart_.end(), fill_.begin());
+    for (int id = 0; id < n; ++id) {
+        int e = entryStart_[id];
+        cover(1, 0, leaves_ - 1, lo[id], hi[id], [&](int node) {
+            entryNode_[e]  = node;
+            entryOwner_[e] = id;
+            entrySlot_[e]  = fill_[node];
+            slots_[fill_[node]++] = e;
+            ++e;
+        });
+    }
+    runStart_.fill(0, leaves_ + 1);
+    runActive_.fill(0, leaves_);
+    for (int id = 0; id < n; ++id) ++runStart_[lo[id] + 1];
+    for (int r = 0; r < leaves_; ++r) runStart_[r + 1] += runStart_[r];
+    runSlots_.resize(n);
+    runPos_.resize(n);
+    fill_.resize(leaves_ + 1);
+    std::copy(runStart_.begin(), runStart_.end(), fill_.begin());
+    for (int id = 0; id < n; ++id) {
+        runPos_[id] = fill_[lo[id]];
+        runSlots_[fill_[lo[id]]++] = id;
+    }
+}
+
+template<class Fn> void YRangeIndex::query(int lo, int hi, Fn&& fn) const {
+    int node = 1, l = 0, r = leaves_ - 1;
+    for (;;) {
+        for (int s = nodeStart_[node]; s < nodeStart_[node] + nodeActive_[node]; ++s) fn(entryOwner_[slots_[s]]);
+        if (l == r) break;
+        const int m = (l + r) / 2;
+        if (lo <= m) { node = 2 * node;     r = m; }
+        else         { node = 2 * node + 1; l = m + 1; }
+    }
+    if (lo < hi) reportStarts(1, 0, leaves_ - 1, lo + 1, hi, fn);
+}
+
+template<class Fn> void YRangeIndex::cover(int node, int l, int r, int lo, int hi, Fn&& fn) {
+    if (hi < l || r < lo) return;
+    if (lo <= l && r <= hi) {
+        fn(node);
+        return;
+    }
+    const int m = (l + r) / 2;
+    cover(2 * node, l, m, lo, hi, fn);
+    cover(2 * node + 1, m + 1, r, lo, hi, fn);
+}
+
+template<class Fn> void YRangeIndex::reportStarts(int node, int l, int r, int lo, int hi, Fn&& fn) const {
+    if (hi < l || r < lo || count_[node] == 0) return;
+    if (l == r) {
+        for (int s = runStart_[l]; s < runStart_[l] + runActive_[l]; ++s) fn(runSlots_[s]);
+        return;
+    }
+    const int m = (l + r) / 2;
+    reportStarts(2 * node, l, m, lo, hi, fn);
+    reportStarts(2 * node + 1, m + 1, r, lo, hi, fn);
+}
+
+void YRangeIndex::toggle(int id, bool on) {
+    for (int e = entryStart_[id]; e < entryStart_[id + 1]; ++e) {
+        const int node   = entryNode_[e];
+        const int target = nodeStart_[node] + (on ? nodeActive_[node]++ : --nodeActive_[node]);
+        const int other  = slots_[target];
+        slots_[entrySlot_[e]] = other;
+        entrySlot_[other]     = entrySlot_[e];
+        slots_[target]        = e;
+        entrySlot_[e]         = target;
+    }
+    const int rank   = lo_[id];
+    const int target = runStart_[rank] + (on ? runActive_[rank]++ : --runActive_[rank]);
+    const int other  = runSlots_[target];
+    runSlots_[runPos_[id]] = other;
+    runPos_[other]         = runPos_[id];
+    runSlots_[target]      = id;
+    runPos_[id]            = target;
+    int node = 1, l = 0, r = leaves_ - 1;
+    for (;;) {
+        count_[node] += on ? 1 : -1;
+        if (l == r) break;
+        const int m = (l + r) / 2;
+        if (rank <= m) { node = 2 * node;     r = m; }
+        else           { node = 2 * node + 1; l = m + 1; }
+    }
+}
+
+// ranks of the box y extents among all values of ys, sorted and deduplicated
+static void rankBoxesY(const QVector<EdgeBox>& boxes, const QVector<double>& ys, QVector<int>& lo, QVector<int>& hi) {
+    lo.resize(boxes.size());
+    hi.resize(boxes.size());
+    for (int i = 0; i < boxes.size(); ++i) {
+        lo[i] = int(std::lower_bound(ys.begin(), ys.end(), boxes[i].minY) - ys.begin());
+        hi[i] = int(std::lower_bound(ys.begin(), ys.end(), boxes[i].maxY) - ys.begin());
+    }
+}
+
+static void appendBoxesY(const QVector<EdgeBox>& boxes, QVector<double>& ys) {
+    for (const auto& b : boxes) {
+        ys.push_back(b.minY);
+        ys.push_back(b.maxY);
+    }
+}
+
+static void sortUnique(QVector<double>& ys) {
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+}
+
+static void sortPairs(QVector<EdgePair>& pairs) {
+    std::sort(pairs.begin(), pairs.end(), [](const EdgePair& l, const EdgePair& r) {
+        return l.a != r.a ? l.a < r.a : l.b < r.b;
+    });
+}
+
+// begins before ends at equal x so that touching boxes still meet
+static void sortEvents(QVector<SweepEvent>& events) {
+    std::sort(events.begin(), events.end(), [](const SweepEvent& l, const SweepEvent& r) {
+        if (l.x != r.x) return l.x < r.x;
+        return !l.isEnd && r.isEnd;
+    });
+}
+
+QVector<EdgePair> sweepCandidatePairs(const QVector<EdgeBox>& boxesA, const QVector<EdgeBox>& boxesB) {
+    CandidateBuffers buf;
+    QVector<EdgePair> pairs;
+    sweepCandidatePairs(boxesA, boxesB, pairs, buf);
+    return pairs;
+}
+
+void sweepCandidatePairs(const QVector<EdgeBox>& boxesA, const QVector<EdgeBox>& boxesB, QVector<EdgePair>& out,
+                         CandidateBuffers& buf) {
+    out.clear();
+    QVector<SweepEvent>& events = buf.events;
+    events.clear();
+    events.reserve(2 * (boxesA.size() + boxesB.size()));
+    for (int i = 0; i < boxesA.size(); ++i) {
+        events.push_back({ boxesA[i].minX, false, true, i });
+        events.push_back({ boxesA[i].maxX, true,  true, i });
+    }
+    for (int j = 0; j < boxesB.size(); ++j) {
+        events.push_back({ boxesB[j].minX, false, false, j });
+        events.push_back({ boxesB[j].maxX, true,  false, j });
+    }
+    sortEvents(events);
+    // status: active y-ranges of each side, ranked over the ys of both
+    QVector<double>& ys = buf.ys;
+    ys.clear();
+    ys.reserve(2 * (boxesA.size() + boxesB.size()));
+    appendBoxesY(boxesA, ys);
+    appendBoxesY(boxesB, ys);
+    sortUnique(ys);
+    const QVector<int>& loA = buf.loA;
+    const QVector<int>& hiA = buf.hiA;
+    const QVector<int>& loB = buf.loB;
+    const QVector<int>& hiB = buf.hiB;
+    rankBoxesY(boxesA, ys, buf.loA, buf.hiA);
+    rankBoxesY(boxesB, ys, buf.loB, buf.hiB);
+    YRangeIndex& activeA = buf.activeA;
+    YRangeIndex& activeB = buf.activeB;
+    activeA.build(loA, hiA, ys.size());
+    activeB.build(loB, hiB, ys.size());
+    for (int e = 0; e < events.size(); ++e) {
+        if ((e & 1023) == 0 && cancelRequested()) {
+            out.clear();
+            return;
+        }
+        const SweepEvent& ev = events[e];
+        YRangeIndex& own = ev.fromA ? activeA : activeB;
+        if (ev.isEnd) {
+            own.erase(ev.idx);
+            continue;
+        }
+        if (ev.fromA) activeB.query(loA[ev.idx], hiA[ev.idx], [&](int j) { out.push_back({ ev.idx, j }); });
+        else          activeA.query(loB[ev.idx], hiB[ev.idx], [&](int i) { out.push_back({ i, ev.idx }); });
+        own.insert(ev.idx);
+    }
+    sortPairs(out);
+}
+
+QVector<EdgePair> sweepSelfCandidatePairs(const QVector<EdgeBox>& boxes) {
+    CandidateBuffers buf;
+    QVector<EdgePair> pairs;
+    sweepSelfCandidatePairs(boxes, pairs, buf);
+    return pairs;
+}
+
+void sweepSelfCandidatePairs(const QVector<EdgeBox>& boxes, QVector<EdgePair>& out, CandidateBuffers& buf) {
+    out.clear();
+    QVector<SweepEvent>& events = buf.events;
+    events.clear();
+    events.reserve(2 * boxes.size());
+    for (int i = 0; i < boxes.size(); ++i) {
+        events.push_back({ boxes[i].minX, false, true, i });
+        events.push_back({ boxes[i].maxX, true,  true, i });
+    }
+    sortEvents(events);
+    QVector<double>& ys = buf.ys;
+    ys.clear();
+    ys.reserve(2 * boxes.size());
+    appendBoxesY(boxes, ys);
+    sortUnique(ys);
+    const QVector<int>& lo = buf.loA;
+    const QVector<int>& hi = buf.hiA;
+    rankBoxesY(boxes, ys, buf.loA, buf.hiA);
+    YRangeIndex& active = buf.activeA;
+    active.build(lo, hi, ys.size());
+    for (int e = 0; e < events.size(); ++e) {
+        if ((e & 1023) == 0 && cancelRequested()) {
+            out.clear();
+            return;
+        }
+        const SweepEvent& ev = events[e];
+        if (ev.isEnd) {
+            active.erase(ev.idx);
+            continue;
+        }
+        active.query(lo[ev.idx], hi[ev.idx], [&](int j) {
+            out.push_back({ std::min(ev.idx, j), std::max(ev.idx, j) });
+        });
+        active.insert(ev.idx);
+    }
+    sortPairs(out);
+}
+
+// r = a1 - a0 and s = b1 - b0 come in precomputed; every expression keeps
+// the operand order of the original QPointF code, so both overloads agree
+// to the bit
+static inline SegmentIntersection intersectCore(double a0x, double a0y, double a1x, double a1y, double rx, double ry,
+                                                double b0x, double b0y, double b1x, double b1y, double sx, double sy,
+                                                double epsGeom) {
     SegmentIntersection out;
-    QPointF r = A1 - A0;
-    QPointF s = B1 - B0;
-    double rxs = cross2d(r, s);
-    QPointF diff = B0 - A0;
-    double diffxr = cross2d(diff, r);
+    double rxs = rx * sy - ry * sx;
+    const double ex = b0x - a0x;
+    const double ey = b0y - a0y;
+    double diffxr = ex * ry - ey * rx;
     if (std::fabs(rxs) > epsGeom) {
-        double t = cross2d(diff, s) / rxs;
-        double u = cross2d(diff, r) / rxs;
+        double t = (ex * sy - ey * sx) / rxs;
+        double u = diffxr / rxs;
         if (t >= -epsGeom && t <= 1.0+epsGeom &&
             u >= -epsGeom && u <= 1.0+epsGeom) {
             if (t < 0.0) t = 0.0;
@@ -89,33 +444,34 @@ SegmentIntersection intersectSegments(const QPointF& A0, const QPointF& A1, cons
             if (u < 0.0) u = 0.0;
             if (u > 1.0) u = 1.0;
             out.type = IntersectType::Point;
+            out.transversal = true;
             out.tA = t;
             out.tB = u;
-            out.P = A0 + r * t;
+            out.P = QPointF(a0x + rx * t, a0y + ry * t);
         }
         return out;
     }
     if (std::fabs(diffxr) > epsGeom) {
         return out;
     }
-    double rr = dot2d(r, r);
-    double ss = dot2d(s, s);
-    auto paramOnA = [&](const QPointF& P)->double {
+    double rr = rx * rx + ry * ry;
+    double ss = sx * sx + sy * sy;
+    auto paramOnA = [&](double px, double py)->double {
         if (rr < epsGeom) return 0.0;
-        return dot2d(P - A0, r) / rr;
+        return ((px - a0x) * rx + (py - a0y) * ry) / rr;
     };
-    double tA_for_B0 = paramOnA(B0);
-    double tA_for_B1 = paramOnA(B1);
+    double tA_for_B0 = paramOnA(b0x, b0y);
+    double tA_for_B1 = paramOnA(b1x, b1y);
     double tA_lo, tA_hi;
     if (!intervalIntersection(0.0, 1.0, tA_for_B0, tA_for_B1, tA_lo, tA_hi)) {
         return out;
     }
-    auto paramOnB = [&](const QPointF& P)->double {
+    auto paramOnB = [&](double px, double py)->double {
         if (ss < epsGeom) return 0.0;
-        return dot2d(P - B0, s) / ss;
+        return ((px - b0x) * sx + (py - b0y) * sy) / ss;
     };
-    double tB_for_A0 = paramOnB(A0);
-    double tB_for_A1 = paramOnB(A1);
+    double tB_for_A0 = paramOnB(a0x, a0y);
+    double tB_for_A1 = paramOnB(a1x, a1y);
     double tB_lo, tB_hi;
     if (!intervalIntersection(0.0, 1.0, tB_for_A0, tB_for_A1, tB_lo, tB_hi)) {
         return out;
@@ -128,7 +484,7 @@ SegmentIntersection intersectSegments(const QPointF& A0, const QPointF& A1, cons
         double tB_mid = 0.5 * (tB_lo + tB_hi);
         out.tA = tA_mid;
         out.tB = tB_mid;
-        out.P  = lerpPoint(A0, A1, tA_mid);
+        out.P  = QPointF(a0x + rx * tA_mid, a0y + ry * tA_mid);
         return out;
     }
     if (tA_lo > tA_hi) std::swap(tA_lo, tA_hi);
@@ -141,21 +497,108 @@ SegmentIntersection intersectSegments(const QPointF& A0, const QPointF& A1, cons
     return out;
 }
 
-static QVector<AtomicSegment> explodeEdgeWork(const EdgeWork& ew, const PolygonTopo& poly,double epsParam) {
-    QVector<AtomicSegment> out;
-    if (ew.cutParams.isEmpty()) return out;
-    QVector<double> params = ew.cutParams;
-    std::sort(params.begin(), params.end());
-    params.erase(std::unique(params.begin(), params.end(), [epsParam](double a, double b){
+SegmentIntersection intersectSegments(const QPointF& A0, const QPointF& A1, const QPointF& B0, const QPointF& B1, double epsGeom) {
+    return intersectCore(A0.x(), A0.y(), A1.x(), A1.y(), A1.x() - A0.x(), A1.y() - A0.y(),
+                         B0.x(), B0.y(), B1.x(), B1.y(), B1.x() - B0.x(), B1.y() - B0.y(), epsGeom);
+}
+
+SegmentIntersection intersectSegments(const EdgeArrays& A, int i, const EdgeArrays& B, int j, double epsGeom) {
+    return intersectCore(A.x0[i], A.y0[i], A.x1[i], A.y1[i], A.dx[i], A.dy[i],
+                         B.x0[j], B.y0[j], B.x1[j], B.y1[j], B.dx[j], B.dy[j], epsGeom);
+}
+
+// boundary events met since the last emitted atom of the current loop
+struct LinkCarry {
+    int  crosses = 0;
+    bool dirty   = true; // a fresh loop starts unknown
+};
+
+static StatusLink resolveLink(const LinkCarry& c) {
+    if (c.dirty || c.crosses > 1) return StatusLink::Retest;
+    return c.crosses == 0 ? StatusLink::Same : StatusLink::FlipOther;
+}
+
+// groups the records of work per edge with a stable counting sort; each
+// start array serves as the write cursor and is shifted back afterwards
+static void buildCutLists(const EdgeWork& work, EdgeCutLists& f) {
+    const int n = work.edges.size();
+    f.paramStart.fill(0, n + 1);
+    f.crossStart.fill(0, n + 1);
+    f.dirtyStart.fill(0, n + 1);
+    f.overlapStart.fill(0, n + 1);
+    for (const auto& rec : work.cuts) {
+        const int span = (rec.type == IntersectType::Overlap) ? 2 : 1;
+        f.paramStart[rec.edge + 1] += span;
+        if (rec.cross) ++f.crossStart[rec.edge + 1];
+        if (rec.dirty) f.dirtyStart[rec.edge + 1] += span;
+        if (rec.coincident) ++f.overlapStart[rec.edge + 1];
+    }
+    for (int i = 0; i < n; ++i) {
+        f.paramStart[i + 1]   += f.paramStart[i] + 2;
+        f.crossStart[i + 1]   += f.crossStart[i];
+        f.dirtyStart[i + 1]   += f.dirtyStart[i];
+        f.overlapStart[i + 1] += f.overlapStart[i];
+    }
+    f.params.resize(f.paramStart[n]);
+    f.crosses.resize(f.crossStart[n]);
+    f.dirty.resize(f.dirtyStart[n]);
+    f.overlaps.resize(f.overlapStart[n]);
+    for (int i = 0; i < n; ++i) {
+        f.params[f.paramStart[i]++] = 0.0;
+        f.params[f.paramStart[i]++] = 1.0;
+    }
+    for (const auto& rec : work.cuts) {
+        const bool overlap = (rec.type == IntersectType::Overlap);
+        f.params[f.paramStart[rec.edge]++] = rec.t0;
+        if (overlap) f.params[f.paramStart[rec.edge]++] = rec.t1;
+        if (rec.cross) f.crosses[f.crossStart[rec.edge]++] = rec.t0;
+        if (rec.dirty) {
+            f.dirty[f.dirtyStart[rec.edge]++] = rec.t0;
+            if (overlap) f.dirty[f.dirtyStart[rec.edge]++] = rec.t1;
+        }
+        if (rec.coincident) f.overlaps[f.overlapStart[rec.edge]++] = rec;
+    }
+    // every cursor now sits on the start of the next edge
+    for (QVector<int>* start : { &f.paramStart, &f.crossStart, &f.dirtyStart, &f.overlapStart }) {
+        for (int i = n; i > 0; --i) (*start)[i] = (*start)[i - 1];
+        (*start)[0] = 0;
+    }
+}
+
+// sorts and deduplicates the lists of edge i in place before cutting it
+static void explodeOneEdge(const RawEdge& e, int i, EdgeCutLists& f, const PolygonTopo& poly, double epsParam,
+                           LinkCarry& carry, qint64& keptParams, QVector<AtomicSegment>& out) {
+    double* params = f.params.data() + f.paramStart[i];
+    double* crossBegin = f.crosses.data() + f.crossStart[i];
+    double* crossEnd   = f.crosses.data() + f.crossStart[i + 1];
+    double* dirtyBegin = f.dirty.data() + f.dirtyStart[i];
+    double* dirtyEnd   = f.dirty.data() + f.dirtyStart[i + 1];
+    const CutRecord* ovBegin = f.overlaps.constData() + f.overlapStart[i];
+    const CutRecord* ovEnd   = f.overlaps.constData() + f.overlapStart[i + 1];
+    std::sort(params, params + (f.paramStart[i + 1] - f.paramStart[i]));
+    const int kept = int(std::unique(params, params + (f.paramStart[i + 1] - f.paramStart[i]),
+                                     [epsParam](double a, double b){
         return std::fabs(a - b) < epsParam;
-    }),
-    params.end());
-    const QPointF P0 = poly.verts[ew.edge.vStart].pos;
-    const QPointF P1 = poly.verts[ew.edge.vEnd ].pos;
+    }) - params);
+    keptParams += kept;
+    std::sort(crossBegin, crossEnd);
+    std::sort(dirtyBegin, dirtyEnd);
+    // unique() folds every raw cut in [params[k], params[k+1]) into params[k]
+    auto absorbCluster = [&](int k) {
+        const double lo = params[k];
+        const double hi = (k + 1 < kept) ? params[k+1] : std::numeric_limits<double>::infinity();
+        auto countIn = [&](const double* b, const double* e) {
+            return int(std::lower_bound(b, e, hi) - std::lower_bound(b, e, lo));
+        };
+        carry.crosses += countIn(crossBegin, crossEnd);
+        if (countIn(dirtyBegin, dirtyEnd) > 0) carry.dirty = true;
+    };
+    const QPointF P0 = poly.verts[e.vStart].pos;
+    const QPointF P1 = poly.verts[e.vEnd  ].pos;
     auto isInOverlap = [&](double t0, double t1)->bool {
-        for (const auto& ov : ew.overlaps) {
-            double a = ov.t0;
-            double b = ov.t1;
+        for (const CutRecord* ov = ovBegin; ov != ovEnd; ++ov) {
+            double a = ov->t0;
+            double b = ov->t1;
             if (a > b) std::swap(a,b);
             if (t0 >= a - epsParam && t1 <= b + epsParam) {
                 return true;
@@ -163,72 +606,330 @@ static QVector<AtomicSegment> explodeEdgeWork(const EdgeWork& ew, const PolygonT
         }
         return false;
     };
-    for (int k = 0; k+1 < params.size(); ++k) {
+    for (int k = 0; k+1 < kept; ++k) {
         double tLo = params[k];
         double tHi = params[k+1];
+        absorbCluster(k);
         if (tHi - tLo < epsParam) {
             continue;
         }
         QPointF A = lerpPoint(P0, P1, tLo);
         QPointF B = lerpPoint(P0, P1, tHi);
+        if (A.x() == B.x() && A.y() == B.y()) {
+            continue; // zero-length edge, its events carry on to the next atom
+        }
         AtomicSegment seg;
         seg.p0 = A;
         seg.p1 = B;
-        seg.fromA = ew.edge.fromA;
-        seg.loopId = ew.edge.loopId;
+        seg.fromA = e.fromA;
+        seg.loopId = e.loopId;
         seg.coincidentWithOther = isInOverlap(tLo, tHi);
+        seg.link = resolveLink(carry);
+        carry = LinkCarry{ 0, false };
         out.push_back(seg);
     }
-    return out;
+    absorbCluster(kept - 1);
 }
 
-QVector<AtomicSegment> computeAtomicSegments(const PolygonTopo& polyA, const PolygonTopo& polyB, double epsGeom, double epsParam) {
-    QVector<RawEdge> rawA = buildRawEdges(polyA, /*fromA=*/true);
-    QVector<RawEdge> rawB = buildRawEdges(polyB, /*fromA=*/false);
-    QVector<EdgeWork> workA, workB;
-    workA.reserve(rawA.size());
-    workB.reserve(rawB.size());
-    for (const auto& e : rawA) { EdgeWork w; w.edge = e; w.cutParams = {0.0, 1.0}; workA.push_back(w); }
-    for (const auto& e : rawB) { EdgeWork w; w.edge = e; w.cutParams = {0.0, 1.0}; workB.push_back(w); }
-    injectSelfCollinearCuts(polyA, rawA, workA, epsGeom, epsParam);
-    injectSelfCollinearCuts(polyB, rawB, workB, epsGeom, epsParam);
-    for (int i = 0; i < workA.size(); ++i) {
-        for (int j = 0; j < workB.size(); ++j) {
-            const QPointF A0 = polyA.verts[ workA[i].edge.vStart ].pos;
-            const QPointF A1 = polyA.verts[ workA[i].edge.vEnd   ].pos;
-            const QPointF B0 = polyB.verts[ workB[j].edge.vStart ].pos;
-            const QPointF B1 = polyB.verts[ workB[j].edge.vEnd   ].pos;
-            SegmentIntersection inter = intersectSegments(A0, A1, B0, B1, epsGeom);
-            if (inter.type == IntersectType::None) continue;
-            if (inter.type == IntersectType::Point) {
-                workA[i].cutParams.push_back(inter.tA);
-                workB[j].cutParams.push_back(inter.tB);
-            } else if (inter.type == IntersectType::Overlap) {
-                workA[i].cutParams.push_back(inter.tA0);
-                workA[i].cutParams.push_back(inter.tA1);
-                workA[i].overlaps.push_back({ inter.tA0, inter.tA1 });
-
-                workB[j].cutParams.push_back(inter.tB0);
-                workB[j].cutParams.push_back(inter.tB1);
-                workB[j].overlaps.push_back({ inter.tB0, inter.tB1 });
-            }
+struct ChunkCuts {
+    QVector<CutRecord> a;
+    QVector<CutRecord> b;
+    qint64 boxRejected    = 0;
+    qint64 kernelRejected = 0;
+};
+
+static inline bool isInteriorParam(double t, double epsParam) {
+    return t > epsParam && t < 1.0 - epsParam;
+}
+
+static bool makeCutRecords(const SegmentIntersection& inter, int i, int j, double epsParam, CutRecord& ra, CutRecord& rb) {
+    if (inter.type == IntersectType::Point) {
+        const bool cross = inter.transversal &&
+                           isInteriorParam(inter.tA, epsParam) && isInteriorParam(inter.tB, epsParam);
+        ra = { i, inter.type, cross, !cross, false, inter.tA, inter.tA };
+        rb = { j, inter.type, cross, !cross, false, inter.tB, inter.tB };
+        return true;
+    }
+    if (inter.type == IntersectType::Overlap) {
+        ra = { i, inter.type, false, true, true, inter.tA0, inter.tA1 };
+        rb = { j, inter.type, false, true, true, inter.tB0, inter.tB1 };
+        return true;
+    }
+    return false;
+}
+
+static int resolveThreadCount(int requested) {
+    if (requested > 0) return requested;
+    return qMax(1, int(std::thread::hardware_concurrency()));
+}
+
+// runs fn(0 .. chunkCount-1) on up to `threads` threads, chunks are handed out in order
+static void runChunksInParallel(int chunkCount, int threads, const std::function<void(int)>& fn) {
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int c = next++; c < chunkCount; c = next++) fn(c);
+    };
+    std::vector<std::thread> pool;
+    const int extra = qMin(threads, chunkCount) - 1;
+    pool.reserve(qMax(0, extra));
+    for (int t = 0; t < extra; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+EdgeWork initEdgeWork(const QVector<RawEdge>& edges) {
+    EdgeWork work;
+    work.edges = edges;
+    return work;
+}
+
+// the A x B pass on prepared edge arrays; the scratch vectors of buf are
+// reused, its edge arrays are not touched
+static void intersectCuts(const EdgeArrays& arrA, EdgeWork& workA, const EdgeArrays& arrB, EdgeWork& workB,
+                          double epsGeom, double epsParam, const AtomizeOptions& opts, AtomizeBuffers& buf,
+                          const EdgeIndex* indexA = nullptr) {
+    StageTimer timer(&PipelineStats::intersectNs);
+    const int nA = arrA.size();
+    const int nB = arrB.size();
+    CandidateBuffers& cand = buf.candidates;
+    QVector<EdgePair>& pairs = cand.pairs;
+    pairs.clear();
+    const bool allPairs = (opts.mode == IntersectMode::BruteForce);
+    if (opts.mode == IntersectMode::SweepLine) {
+        edgeBoxes(arrA, cand.boxesA);
+        edgeBoxes(arrB, cand.boxesB);
+        sweepCandidatePairs(cand.boxesA, cand.boxesB, pairs, cand);
+    } else if (opts.mode == IntersectMode::GridIndex || opts.mode == IntersectMode::RTreeIndex) {
+        const EdgeIndex::Backend backend = (opts.mode == IntersectMode::GridIndex) ? EdgeIndex::Backend::Grid
+                                                                                   : EdgeIndex::Backend::RTree;
+        if (!indexA || indexA->backend() != backend || indexA->size() != nA) {
+            if (!buf.index) buf.index = std::make_unique<EdgeIndex>();
+            edgeBoxes(arrA, cand.boxesA);
+            buf.index->build(cand.boxesA, backend);
+            indexA = buf.index.get();
         }
+        edgeBoxes(arrB, cand.boxesB);
+        indexA->candidatePairs(cand.boxesB, pairs, cand);
     }
-    QVector<AtomicSegment> allSegs;
-    allSegs.reserve(workA.size() * 2 + workB.size() * 2);
-    for (const auto& ew : workA) {
-        QVector<AtomicSegment> parts = explodeEdgeWork(ew, polyA, epsParam);
-        for (const auto& seg : parts) {
-            allSegs.push_back(seg);
+    if (cancelRequested()) return;
+    // pairs are sorted by a, so the partners of A edge i are pairs[rowStart[i] .. rowStart[i+1])
+    QVector<int>& rowStart = buf.rowStart;
+    if (!allPairs) {
+        rowStart.fill(0, nA + 1);
+        for (const auto& pr : pairs) ++rowStart[pr.a + 1];
+        for (int i = 0; i < nA; ++i) rowStart[i + 1] += rowStart[i];
+    }
+    // partners of every indexed A edge as a plain index run for the batched pre-test
+    QVector<int>& partnerB = buf.partnerB;
+    if (!allPairs) {
+        partnerB.resize(pairs.size());
+        for (int k = 0; k < pairs.size(); ++k) partnerB[k] = pairs[k].b;
+    }
+    auto testPair = [&](int i, int j) {
+        return intersectSegments(arrA, i, arrB, j, epsGeom);
+    };
+    // brute force first drops the partners with disjoint padded boxes, which
+    // the indexed modes have already done; survivors keep their order, so the
+    // cuts are pushed as without the pre-tests
+    auto forEachPartner = [&](int i, QVector<int>& boxed, QVector<int>& survivors,
+                              qint64& boxRejected, qint64& kernelRejected, auto&& fn) {
+        const int* js = nullptr;
+        int count = 0;
+        if (allPairs) {
+            boxed.resize(nB);
+            count = filterBoxRange(arrA, i, arrB, 0, nB, boxed.data());
+            boxRejected += nB - count;
+            js = boxed.constData();
+        } else {
+            js = partnerB.constData() + rowStart[i];
+            count = rowStart[i + 1] - rowStart[i];
         }
+        survivors.resize(count);
+        const int kept = filterPartners(arrA, i, arrB, js, count, epsGeom, survivors.data());
+        kernelRejected += count - kept;
+        for (int k = 0; k < kept; ++k) fn(survivors[k]);
+    };
+
+    qint64 pointHits = 0;
+    qint64 overlapHits = 0;
+    qint64 boxRejected = 0;
+    qint64 kernelRejected = 0;
+    const int threads = resolveThreadCount(opts.threads);
+    if (threads <= 1 || nA < 2) {
+        for (int i = 0; i < nA; ++i) {
+            if ((i & 255) == 0) {
+                if (cancelRequested()) return;
+                reportProgress(PipelineStage::Intersect, double(i) / nA);
+            }
+            forEachPartner(i, buf.boxed, buf.survivors, boxRejected, kernelRejected, [&](int j) {
+                CutRecord ra, rb;
+                if (makeCutRecords(testPair(i, j), i, j, epsParam, ra, rb)) {
+                    ++(ra.type == IntersectType::Point ? pointHits : overlapHits);
+                    workA.cuts.push_back(ra);
+                    workB.cuts.push_back(rb);
+                }
+            });
+        }
+    } else {
+        // contiguous A ranges of roughly equal pair count; each chunk records its
+        // cuts locally and the chunks are replayed in A order, which reproduces
+        // the serial push order on both sides
+        const qint64 totalWork = allPairs ? qint64(nA) * qMax<qint64>(1, nB)
+                                          : qint64(pairs.size()) + nA;
+        const qint64 target = qMax<qint64>(1, totalWork / (qint64(threads) * 8));
+        QVector<int> chunkStart;
+        chunkStart.push_back(0);
+        qint64 acc = 0;
+        for (int i = 0; i < nA; ++i) {
+            acc += allPairs ? qMax<qint64>(1, nB) : qint64(rowStart[i + 1] - rowStart[i]) + 1;
+            if (acc >= target && i + 1 < nA) {
+                chunkStart.push_back(i + 1);
+                acc = 0;
+            }
+        }
+        chunkStart.push_back(nA);
+        const int chunkCount = chunkStart.size() - 1;
+
+        // the pool threads see no ControlScope, they poll the caller's control
+        PipelineControl* control = activeControl();
+        std::atomic<int> chunksDone{0};
+        QVector<ChunkCuts> chunks(chunkCount);
+        runChunksInParallel(chunkCount, threads, [&](int c) {
+            ChunkCuts& out = chunks[c];
+            QVector<int> boxed, survivors;
+            for (int i = chunkStart[c]; i < chunkStart[c + 1]; ++i) {
+                if (((i - chunkStart[c]) & 255) == 0 && control && control->isCanceled()) return;
+                forEachPartner(i, boxed, survivors, out.boxRejected, out.kernelRejected, [&](int j) {
+                    CutRecord ra, rb;
+                    if (makeCutRecords(testPair(i, j), i, j, epsParam, ra, rb)) {
+                        out.a.push_back(ra);
+                        out.b.push_back(rb);
+                    }
+                });
+            }
+            if (control) control->report(PipelineStage::Intersect, double(++chunksDone) / chunkCount);
+        });
+        if (cancelRequested()) return;
+        for (const auto& chunk : chunks) {
+            boxRejected    += chunk.boxRejected;
+            kernelRejected += chunk.kernelRejected;
+            for (const auto& rec : chunk.a) ++(rec.type == IntersectType::Point ? pointHits : overlapHits);
+            workA.cuts.append(chunk.a);
+            workB.cuts.append(chunk.b);
+        }
+    }
+    if (PipelineStats* stats = activeStats()) {
+        stats->candidatePairs += allPairs ? qint64(nA) * nB : qint64(pairs.size());
+        stats->boxRejected    += boxRejected;
+        stats->kernelRejected += kernelRejected;
+        stats->pointHits      += pointHits;
+        stats->overlapHits    += overlapHits;
     }
-    for (const auto& ew : workB) {
-        QVector<AtomicSegment> parts = explodeEdgeWork(ew, polyB, epsParam);
-        for (const auto& seg : parts) {
-            allSegs.push_back(seg);
+}
+
+void intersectEdgeWork(const PolygonTopo& polyA, const QVector<RawEdge>& rawA, EdgeWork& workA,
+                       const PolygonTopo& polyB, const QVector<RawEdge>& rawB, EdgeWork& workB,
+                       double epsGeom, double epsParam, const AtomizeOptions& opts) {
+    AtomizeBuffers buf;
+    {
+        StageTimer timer(&PipelineStats::intersectNs);
+        buildEdgeArrays(polyA, rawA, epsGeom, buf.arrA);
+        buildEdgeArrays(polyB, rawB, epsGeom, buf.arrB);
+    }
+    intersectCuts(buf.arrA, workA, buf.arrB, workB, epsGeom, epsParam, opts, buf);
+}
+
+void explodeEdgeWork(const PolygonTopo& poly, const EdgeWork& work, double epsParam, QVector<AtomicSegment>& out) {
+    EdgeCutLists lists;
+    explodeEdgeWork(poly, work, epsParam, out, lists);
+}
+
+void explodeEdgeWork(const PolygonTopo& poly, const EdgeWork& work, double epsParam, QVector<AtomicSegment>& out,
+                     EdgeCutLists& lists) {
+    StageTimer timer(&PipelineStats::explodeNs);
+    const qint64 atomsBefore = out.size();
+    buildCutLists(work, lists);
+    qint64 keptParams = 0;
+    LinkCarry carry;
+    const PipelineStage stage = (work.edges.isEmpty() || work.edges[0].fromA) ? PipelineStage::ExplodeA
+                                                                              : PipelineStage::ExplodeB;
+    for (int i = 0; i < work.edges.size(); ++i) {
+        if ((i & 4095) == 0) {
+            if (cancelRequested()) return;
+            reportProgress(stage, double(i) / work.edges.size());
         }
+        const RawEdge& e = work.edges[i];
+        if (i == 0 || e.loopId != work.edges[i-1].loopId) carry = LinkCarry();
+        explodeOneEdge(e, i, lists, poly, epsParam, carry, keptParams, out);
     }
+    if (PipelineStats* stats = activeStats()) {
+        stats->cutParamsRaw  += lists.params.size();
+        stats->cutParamsKept += keptParams;
+        stats->atoms         += out.size() - atomsBefore;
+    }
+}
+
+QVector<AtomicSegment> computeAtomicSegments(const PolygonTopo& polyA, const PolygonTopo& polyB, double epsGeom, double epsParam, const AtomizeOptions& opts) {
+    AtomizeBuffers buf;
+    QVector<AtomicSegment> allSegs;
+    computeAtomicSegments(polyA, polyB, epsGeom, epsParam, opts, buf, allSegs);
     return allSegs;
 }
 
+// raw edges, arrays and self cuts of one side into storage that is reused
+static void prepareSide(const PolygonTopo& poly, bool fromA, double epsGeom, double epsParam, bool simple,
+                        EdgeWork& work, EdgeArrays& arr, CandidateBuffers& cand) {
+    buildRawEdges(poly, fromA, work.edges);
+    work.cuts.resize(0);
+    {
+        StageTimer timer(&PipelineStats::rawEdgesNs);
+        buildEdgeArrays(poly, work.edges, epsGeom, arr);
+    }
+    if (!simple) injectSelfCuts(work.edges, arr, work, epsGeom, epsParam, cand);
+}
+
+// explodes both sides into out, A first
+static void explodeBoth(const PolygonTopo& polyA, const PolygonTopo& polyB, double epsParam, AtomizeBuffers& buf,
+                        QVector<AtomicSegment>& out) {
+    out.resize(0);
+    out.reserve(2 * (buf.workA.edges.size() + buf.workB.edges.size()));
+    explodeEdgeWork(polyA, buf.workA, epsParam, out, buf.lists);
+    explodeEdgeWork(polyB, buf.workB, epsParam, out, buf.lists);
+}
+
+void computeAtomicSegments(const PolygonTopo& polyA, const PolygonTopo& polyB, double epsGeom, double epsParam,
+                           const AtomizeOptions& opts, AtomizeBuffers& buf, QVector<AtomicSegment>& out) {
+    out.resize(0);
+    prepareSide(polyA, /*fromA=*/true, epsGeom, epsParam, opts.simpleA, buf.workA, buf.arrA, buf.candidates);
+    prepareSide(polyB, /*fromA=*/false, epsGeom, epsParam, opts.simpleB, buf.workB, buf.arrB, buf.candidates);
+    if (cancelRequested()) return;
+    intersectCuts(buf.arrA, buf.workA, buf.arrB, buf.workB, epsGeom, epsParam, opts, buf);
+    if (cancelRequested()) return;
+    explodeBoth(polyA, polyB, epsParam, buf, out);
+}
+
+void prepareEdges(const PolygonTopo& poly, bool fromA, double epsGeom, double epsParam, bool simple, PreparedEdges& out) {
+    out.epsGeom  = epsGeom;
+    out.epsParam = epsParam;
+    CandidateBuffers cand;
+    prepareSide(poly, fromA, epsGeom, epsParam, simple, out.work, out.arr, cand);
+}
+
+void computeAtomicSegments(const PolygonTopo& polyA, const PreparedEdges& prepA, const EdgeIndex* indexA,
+                           const PolygonTopo& polyB, const AtomizeOptions& opts, AtomizeBuffers& buf,
+                           QVector<AtomicSegment>& out) {
+    const double epsGeom  = prepA.epsGeom;
+    const double epsParam = prepA.epsParam;
+    // the edge list is shared with prepA, the cuts are copied as the A x B pass appends to them
+    buf.workA.edges = prepA.work.edges;
+    buf.workA.cuts.resize(0);
+    buf.workA.cuts.append(prepA.work.cuts);
+    out.resize(0);
+    prepareSide(polyB, /*fromA=*/false, epsGeom, epsParam, opts.simpleB, buf.workB, buf.arrB, buf.candidates);
+    if (cancelRequested()) return;
+    intersectCuts(prepA.arr, buf.workA, buf.arrB, buf.workB, epsGeom, epsParam, opts, buf, indexA);
+    if (cancelRequested()) return;
+    explodeBoth(polyA, polyB, epsParam, buf, out);
+}
+
 }
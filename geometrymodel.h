@@ -2,9 +2,12 @@
 #include <QVector>
 #include <QPointF>
 #include <QtGlobal>
+#include <memory>
 
 namespace Geometry {
 
+class EdgeIndex;
+
 struct Vertex {
     QPointF pos;
     bool    isIntersection = false; // intersection point
@@ -27,15 +30,36 @@ struct RawEdge {
     bool fromA; // true : from A, false : from B
 };
 
-struct OverlapInterval {
-    double t0; // start t on segment
-    double t1; // end t on segment
+enum class IntersectType : quint8 {
+    None,
+    Point, // single point
+    Overlap // overlap
 };
 
+// one cut on one edge, an overlap cuts at both of its ends
+struct CutRecord {
+    int           edge; // index in the edge list
+    IntersectType type; // Point uses t0 only
+    bool          cross; // Point that crosses the other polygon transversally, interior on both edges
+    bool          dirty; // any other cut where the in/out status may change
+    bool          coincident; // Overlap with the other polygon
+    double        t0;
+    double        t1;
+};
+
+// Cut work of one edge list. The stages append records in the order they
+// find them, all edges in one buffer; explodeEdgeWork groups them per edge
+// with a stable counting sort. The cuts at 0 and 1 are implied.
 struct EdgeWork {
-    RawEdge edge;
-    QVector<double>          cutParams; // begin with {0.0 , 1.0}
-    QVector<OverlapInterval> overlaps;
+    QVector<RawEdge>   edges;
+    QVector<CutRecord> cuts;
+};
+
+// how the in/out status of an atom follows from the previous atom of its loop
+enum class StatusLink : quint8 {
+    Retest, // unknown, needs a point test
+    Same, // no boundary met in between
+    FlipOther // exactly one transversal crossing with the other polygon
 };
 
 struct AtomicSegment {
@@ -44,18 +68,14 @@ struct AtomicSegment {
     bool    fromA; // true : from A, false : from B
     bool    coincidentWithOther; // on-on candidate
     int     loopId;
-};
-
-enum class IntersectType {
-    None,
-    Point, // single point
-    Overlap // overlap
+    StatusLink link = StatusLink::Retest;
 };
 
 struct SegmentIntersection {
     IntersectType type = IntersectType::None;
 
     // Point
+    bool   transversal = false; // found by the non-parallel branch
     double tA = 0.0;
     double tB = 0.0;
     QPointF P;
@@ -67,7 +87,151 @@ struct SegmentIntersection {
     double tB1 = 0.0;
 };
 
+enum class IntersectMode {
+    BruteForce, // every edge of A against every edge of B
+    SweepLine, // x-sweep over edge boxes, only pairs whose boxes overlap are tested
+    GridIndex, // EdgeIndex grid over A, queried with the boxes of B
+    RTreeIndex // EdgeIndex R-tree over A, queried with the boxes of B
+};
+
+struct AtomizeOptions {
+    IntersectMode mode = IntersectMode::BruteForce;
+    // caller certifies the polygon simple (no two edges within epsGeom apart
+    // from shared vertices), so its self-overlap pass is skipped
+    bool simpleA = false;
+    bool simpleB = false;
+    // threads for the A x B stage, 0 = hardware concurrency, 1 = serial
+    int threads = 1;
+};
+
+struct EdgeBox {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+struct EdgePair {
+    int a; // index in rawA
+    int b; // index in rawB
+};
+
+// Structure-of-arrays copy of one edge list, entry i is edge i. The A x B
+// and self passes stream these instead of going through vStart / vEnd.
+struct EdgeArrays {
+    QVector<double> x0, y0; // start point
+    QVector<double> x1, y1; // end point
+    QVector<double> dx, dy; // x1 - x0, y1 - y0
+    QVector<double> minX, minY, maxX, maxY; // padded box, as buildEdgeBoxes
+    int size() const noexcept { return int(x0.size()); }
+    EdgeBox box(int i) const noexcept { return { minX[i], minY[i], maxX[i], maxY[i] }; }
+};
+
+// one box side crossing the sweep line, fromA only matters for the A x B sweep
+struct SweepEvent {
+    double x;
+    bool   isEnd;
+    bool   fromA;
+    int    idx;
+};
+
+// Sweep status: the y-ranges of the active boxes as a segment tree over y
+// ranks, see geometrymodel.cpp. A sweep rebuilds it in place, so one kept in
+// CandidateBuffers reuses its storage.
+class YRangeIndex {
+public:
+    // ranges as inclusive rank spans, ranks below leafCount
+    void build(const QVector<int>& lo, const QVector<int>& hi, int leafCount);
+    void insert(int id) { toggle(id, true); }
+    void erase(int id) { toggle(id, false); }
+    // fn(id) once for every active range meeting [lo, hi]
+    template<class Fn> void query(int lo, int hi, Fn&& fn) const;
+
+private:
+    template<class Fn> static void cover(int node, int l, int r, int lo, int hi, Fn&& fn);
+    template<class Fn> void reportStarts(int node, int l, int r, int lo, int hi, Fn&& fn) const;
+    void toggle(int id, bool on);
+
+    int leaves_ = 1;
+    QVector<int> lo_; // start rank per range
+    // ranges containing a point: canonical cover entries, slot runs per node
+    QVector<int> nodeStart_, nodeActive_;
+    QVector<int> entryStart_, entryNode_, entryOwner_, entrySlot_, slots_;
+    // ranges by start rank: slot runs per leaf, active count per node
+    QVector<int> runStart_, runActive_, runSlots_, runPos_, count_;
+    QVector<int> fill_;
+};
+
+// Working storage of the candidate pair searches, the sweeps and the
+// EdgeIndex queries. Each search resizes what it uses in place.
+struct CandidateBuffers {
+    QVector<EdgeBox>    boxesA, boxesB; // edgeBoxes() of the edge arrays
+    QVector<SweepEvent> events;
+    QVector<double>     ys; // box y extents, sorted and deduplicated
+    QVector<int>        loA, hiA, loB, hiB; // their ranks per box
+    YRangeIndex         activeA, activeB;
+    QVector<int>        hits, start; // EdgeIndex::candidatePairs
+    QVector<EdgePair>   found;
+    QVector<EdgePair>   pairs; // the result of the last search
+};
+
+// Cut lists of one side grouped per edge by explodeEdgeWork: edge i owns
+// params[paramStart[i] .. paramStart[i+1]) and likewise for the others.
+struct EdgeCutLists {
+    QVector<int>       paramStart, crossStart, dirtyStart, overlapStart;
+    QVector<double>    params; // the implied 0 and 1 first
+    QVector<double>    crosses; // transversal crossings with the other polygon
+    QVector<double>    dirty;
+    QVector<CutRecord> overlaps; // coincident with the other polygon
+};
+
+// Working storage of computeAtomicSegments. A run resizes every vector in
+// place, so a caller that keeps one across runs reuses the capacity.
+struct AtomizeBuffers {
+    AtomizeBuffers();
+    ~AtomizeBuffers();
+    AtomizeBuffers(AtomizeBuffers&&) noexcept;
+    AtomizeBuffers& operator=(AtomizeBuffers&&) noexcept;
+
+    EdgeWork     workA, workB; // their edges double as the raw edge lists
+    EdgeArrays   arrA, arrB; // shared by the self and A x B passes
+    CandidateBuffers candidates; // self and A x B candidate pairs
+    std::unique_ptr<EdgeIndex> index; // index modes without a prepared index, built on first use
+    QVector<int> rowStart, partnerB, boxed, survivors; // A x B pass
+    EdgeCutLists lists; // explodeEdgeWork, one side at a time
+};
+
+// One side prepared once for cutting against many others: its edges with the
+// self cuts already in and their edge arrays. Only read by the prepared
+// computeAtomicSegments, so threads may share one instance.
+struct PreparedEdges {
+    EdgeWork   work;
+    EdgeArrays arr;
+    double     epsGeom  = 1e-3;
+    double     epsParam = 1e-9;
+};
+
 QVector<RawEdge> buildRawEdges(const PolygonTopo& poly, bool fromA);
+void buildRawEdges(const PolygonTopo& poly, bool fromA, QVector<RawEdge>& out);
+
+// boxes are inflated so that no pair accepted by intersectSegments is culled
+QVector<EdgeBox> buildEdgeBoxes(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom);
+
+EdgeArrays buildEdgeArrays(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom);
+void buildEdgeArrays(const PolygonTopo& poly, const QVector<RawEdge>& edges, double epsGeom, EdgeArrays& out);
+
+QVector<EdgeBox> edgeBoxes(const EdgeArrays& arrays);
+void edgeBoxes(const EdgeArrays& arrays, QVector<EdgeBox>& out);
+
+// pairs whose boxes overlap, sorted by (a, b)
+QVector<EdgePair> sweepCandidatePairs(const QVector<EdgeBox>& boxesA, const QVector<EdgeBox>& boxesB);
+// the same pairs written to out, on the working storage of buf; out may be buf.pairs
+void sweepCandidatePairs(const QVector<EdgeBox>& boxesA, const QVector<EdgeBox>& boxesB, QVector<EdgePair>& out,
+                         CandidateBuffers& buf);
+
+// pairs (a < b) of one edge list whose boxes overlap, sorted by (a, b)
+QVector<EdgePair> sweepSelfCandidatePairs(const QVector<EdgeBox>& boxes);
+void sweepSelfCandidatePairs(const QVector<EdgeBox>& boxes, QVector<EdgePair>& out, CandidateBuffers& buf);
 
 SegmentIntersection intersectSegments(
     const QPointF& A0, const QPointF& A1,
@@ -75,11 +239,45 @@ SegmentIntersection intersectSegments(
     double epsGeom
     );
 
+// edge i of A against edge j of B, bit-identical to the QPointF overload
+SegmentIntersection intersectSegments(const EdgeArrays& A, int i, const EdgeArrays& B, int j, double epsGeom);
+
+// pipeline stages, computeAtomicSegments runs them in this order
+EdgeWork initEdgeWork(const QVector<RawEdge>& edges);
+
+void injectSelfCollinearCuts(const PolygonTopo& poly, const QVector<RawEdge>& rawEdges, EdgeWork& work, double epsGeom, double epsParam);
+
+void intersectEdgeWork(const PolygonTopo& polyA, const QVector<RawEdge>& rawA, EdgeWork& workA,
+                       const PolygonTopo& polyB, const QVector<RawEdge>& rawB, EdgeWork& workB,
+                       double epsGeom, double epsParam, const AtomizeOptions& opts = AtomizeOptions());
+
+// appends the atoms of every edge of one side, loops in order
+void explodeEdgeWork(const PolygonTopo& poly, const EdgeWork& work, double epsParam, QVector<AtomicSegment>& out);
+void explodeEdgeWork(const PolygonTopo& poly, const EdgeWork& work, double epsParam, QVector<AtomicSegment>& out,
+                     EdgeCutLists& lists);
+
 QVector<AtomicSegment> computeAtomicSegments(
     const PolygonTopo& polyA,
     const PolygonTopo& polyB,
     double epsGeom   = 1e-3,
-    double epsParam  = 1e-9
+    double epsParam  = 1e-9,
+    const AtomizeOptions& opts = AtomizeOptions()
     );
 
+// the same atoms written to out, on the working storage of buffers
+void computeAtomicSegments(const PolygonTopo& polyA, const PolygonTopo& polyB, double epsGeom, double epsParam,
+                           const AtomizeOptions& opts, AtomizeBuffers& buffers, QVector<AtomicSegment>& out);
+
+// raw edges, edge arrays and, unless simple, self cuts of one side
+void prepareEdges(const PolygonTopo& poly, bool fromA, double epsGeom, double epsParam, bool simple, PreparedEdges& out);
+
+// The atoms with side A taken from prepA, prepared from polyA with fromA set;
+// its self cuts are copied instead of recomputed and eps comes from prepA.
+// When indexA is given (over the boxes of prepA.arr, backend of opts.mode) the
+// index modes query it instead of building their own. opts.simpleA is unused.
+// Same atoms as the unprepared overload.
+void computeAtomicSegments(const PolygonTopo& polyA, const PreparedEdges& prepA, const EdgeIndex* indexA,
+                           const PolygonTopo& polyB, const AtomizeOptions& opts, AtomizeBuffers& buffers,
+                           QVector<AtomicSegment>& out);
+
 }
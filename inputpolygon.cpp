@@ -1,37 +1,69 @@
 #include "inputpolygon.h"
+#include "polygonfile.h"
 
 #include <QFile>
 #include <QIODevice>
 #include <QTextStream>
-#include <QRegularExpression>
 #include <QtGlobal>
-#include <QDebug>
+#include <atomic>
+#include <cctype>
+#include <charconv>
 
 static inline bool almostSame(const QPointF& a, const QPointF& b, qreal eps = 1e-3) {
     return qAbs(a.x() - b.x()) <= eps &&
            qAbs(a.y() - b.y()) <= eps;
 }
 
-void InputPolygon::clearPolygon() noexcept {
-    outer.clear();
-    holes.clear();
+enum class ParseError {
+    None,
+    WrongFormat, // fewer than two fields on a line
+    InvalidValue // a field that is not a number
+};
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
 }
 
-bool InputPolygon::loadData(const QString& filePath, QString* error) {
-    clearPolygon();
+// one field with QString::toDouble rules: the whole token is a number, a
+// leading '+' is allowed
+static inline bool parseField(const char* b, const char* e, double& out) {
+    if (b != e && *b == '+') {
+        ++b;
+        if (b != e && (*b == '+' || *b == '-')) return false;
+    }
+    const auto res = std::from_chars(b, e, out);
+    return res.ec == std::errc() && res.ptr == e;
+}
 
-    QFile loadFile(filePath);
-    if (!loadFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        if (error) {
-            *error = QStringLiteral(
-                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
-                         ).arg(filePath, loadFile.errorString());
-        }
-        return false;
+// tag is lowercase
+static inline bool startsWithTag(const char* b, const char* e, const char* tag, int len) {
+    if (e - b < len) return false;
+    for (int i = 0; i < len; ++i) {
+        if (std::tolower(uchar(b[i])) != tag[i]) return false;
     }
-    QTextStream textStream(&loadFile);
-    int lineCount = 0;
+    return true;
+}
+
+// Scans the text format in place: lines end in \n, \r\n or \r, '#' starts a
+// comment, "#loop" (any case) closes the current loop, "#polygon" closes the
+// current polygon, and a vertex line holds at least two numbers separated by
+// commas or whitespace. The first loop of a polygon becomes its outer one.
+// "#polyline" starts an open polyline that takes the vertices up to the next
+// tag; these go to lines, never closed. lineCount ends on the line of an error.
+static ParseError parsePolygonText(const char* p, const char* end, QVector<InputPolygon>& polys,
+                                   QVector<QVector<QPointF>>& lines, int& lineCount) {
+    if (end - p >= 3 && uchar(p[0]) == 0xEF && uchar(p[1]) == 0xBB && uchar(p[2]) == 0xBF) {
+        p += 3;
+    }
+    QVector<QPointF> outer;
+    QVector<QVector<QPointF>> holes;
     QVector<QPointF> currentLoop;
+    QVector<QPointF> currentLine;
+    bool inLine = false;
+    auto flushCurrentLine = [&]() {
+        if (!currentLine.isEmpty()) lines.push_back(currentLine);
+        currentLine.clear();
+    };
     auto flushCurrentLoop = [&]() {
         if (currentLoop.isEmpty())
             return;
@@ -46,62 +78,278 @@ bool InputPolygon::loadData(const QString& filePath, QString* error) {
         }
         currentLoop.clear();
     };
-    static const QRegularExpression sep("[,\\s]+");
-    while (!textStream.atEnd()) {
-        QString line = textStream.readLine();
+    auto flushPolygon = [&]() {
+        flushCurrentLoop();
+        if (outer.isEmpty())
+            return;
+        polys.push_back(InputPolygon());
+        polys.last().setLoops(outer, holes);
+        outer.clear();
+        holes.clear();
+    };
+    lineCount = 0;
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') ++lineEnd;
+        const char* next = lineEnd;
+        if (next < end && *next == '\r') ++next;
+        if (next < end && *next == '\n' && (next == lineEnd || next[-1] == '\r')) ++next;
         ++lineCount;
-        if (line.isNull()) {
-            break;
-        }
-        line = line.trimmed();
-        if (line.isEmpty()) {
+
+        const char* b = p;
+        const char* e = lineEnd;
+        p = next;
+        while (b < e && isBlank(*b)) ++b;
+        while (e > b && isBlank(e[-1])) --e;
+        if (b == e) {
             continue;
         }
-        if (line.startsWith('#')) {
-            if (line.startsWith("#loop", Qt::CaseInsensitive)) {
+        if (*b == '#') {
+            if (startsWithTag(b, e, "#loop", 5)) {
+                flushCurrentLine();
+                inLine = false;
                 flushCurrentLoop();
+            } else if (startsWithTag(b, e, "#polygon", 8)) {
+                flushCurrentLine();
+                inLine = false;
+                flushPolygon();
+            } else if (startsWithTag(b, e, "#polyline", 9)) {
+                flushCurrentLine();
+                inLine = true;
+                flushPolygon();
             }
             continue;
         }
-        const QStringList parts = line.split(sep, Qt::SkipEmptyParts);
-        if (parts.size() < 2) {
-            if (error) {
-                *error = QStringLiteral(
-                             "ERROR: WRONG FORMAT AT LINE %1."
-                             ).arg(lineCount);
-            }
-            clearPolygon();
-            return false;
+        // only the first two fields are read, like the old split() did
+        const char* tokBegin[2];
+        const char* tokEnd[2];
+        int fields = 0;
+        for (const char* q = b; q < e && fields < 2; ) {
+            while (q < e && (*q == ',' || isBlank(*q))) ++q;
+            if (q == e) break;
+            tokBegin[fields] = q;
+            while (q < e && *q != ',' && !isBlank(*q)) ++q;
+            tokEnd[fields] = q;
+            ++fields;
         }
-        bool okX = false;
-        bool okY = false;
-        const qreal x = parts[0].toDouble(&okX);
-        const qreal y = parts[1].toDouble(&okY);
-        if (!(okX && okY)) {
-            if (error) {
-                *error = QStringLiteral(
-                             "ERROR: INVALID VALUE AT LINE %1."
-                             ).arg(lineCount);
-            }
-            clearPolygon();
+        if (fields < 2) {
+            return ParseError::WrongFormat;
+        }
+        double x = 0.0;
+        double y = 0.0;
+        if (!parseField(tokBegin[0], tokEnd[0], x) || !parseField(tokBegin[1], tokEnd[1], y)) {
+            return ParseError::InvalidValue;
+        }
+        (inLine ? currentLine : currentLoop).push_back(QPointF(x, y));
+    }
+    flushCurrentLine();
+    flushPolygon();
+    return ParseError::None;
+}
+
+// every polygon and open polyline of a text or binary file, a binary file
+// holds one polygon
+static bool readPolygonFile(const QString& filePath, QVector<InputPolygon>& polys, QVector<QVector<QPointF>>& lines,
+                            QString* error) {
+    polys.clear();
+    lines.clear();
+    QFile loadFile(filePath);
+    if (!loadFile.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
+                         ).arg(filePath, loadFile.errorString());
+        }
+        return false;
+    }
+    // map the file where possible, pipes and the like are read into memory
+    const qint64 fileSize = loadFile.size();
+    const char* data = nullptr;
+    QByteArray buffer;
+    if (fileSize > 0) {
+        data = reinterpret_cast<const char*>(loadFile.map(0, fileSize));
+    }
+    qint64 dataSize = fileSize;
+    if (!data) {
+        buffer = loadFile.readAll();
+        data = buffer.constData();
+        dataSize = buffer.size();
+    }
+
+    if (PolygonFileView::hasMagic(data, dataSize)) {
+        PolygonFileView view;
+        if (!view.openMemory(data, dataSize, error)) {
             return false;
         }
-        currentLoop.push_back(QPointF(x, y));
+        polys.resize(1);
+        view.toInputPolygon(polys[0]);
+        if (polys[0].checkEmpty()) polys.clear();
+        return true;
+    }
+    // QTextStream used to decode UTF-16 files by their BOM, keep accepting them
+    if (dataSize >= 2 && ((uchar(data[0]) == 0xFF && uchar(data[1]) == 0xFE) ||
+                          (uchar(data[0]) == 0xFE && uchar(data[1]) == 0xFF))) {
+        buffer = QString::fromUtf16(reinterpret_cast<const char16_t*>(data), dataSize / 2).toUtf8();
+        data = buffer.constData();
+        dataSize = buffer.size();
+    }
+    int lineCount = 0;
+    const ParseError parseError = parsePolygonText(data, data + dataSize, polys, lines, lineCount);
+    if (parseError != ParseError::None) {
+        if (error) {
+            *error = (parseError == ParseError::WrongFormat)
+                         ? QStringLiteral("ERROR: WRONG FORMAT AT LINE %1.").arg(lineCount)
+                         : QStringLiteral("ERROR: INVALID VALUE AT LINE %1.").arg(lineCount);
+        }
+        polys.clear();
+        lines.clear();
+        return false;
+    }
+    return true;
+}
+
+// loadData and loadAll refuse polyline files instead of reading no polygons
+static bool rejectPolylines(const QString& filePath, const QVector<QVector<QPointF>>& lines, QString* error) {
+    if (lines.isEmpty()) return true;
+    if (error) {
+        *error = QStringLiteral(
+                     "ERROR: FILE %1 HOLDS %2 OPEN POLYLINES, EXPECTED POLYGONS."
+                     ).arg(filePath).arg(lines.size());
+    }
+    return false;
+}
+
+// writes the text format through write(textStream), reporting open and write failures
+template<class WriteFn>
+static bool writeTextFile(const QString& filePath, QString* error, WriteFn&& write) {
+    QFile saveFile(filePath);
+    if (!saveFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
+                         ).arg(filePath, saveFile.errorString());
+        }
+        return false;
+    }
+    QTextStream textStream(&saveFile);
+    write(textStream);
+    textStream.flush();
+    if (textStream.status() != QTextStream::Ok) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO WRITE FILE %1. (%2)."
+                         ).arg(filePath, saveFile.errorString());
+        }
+        return false;
+    }
+    return true;
+}
+
+static void writePoints(QTextStream& textStream, const QVector<QPointF>& points) {
+    for (const QPointF& p : points) {
+        textStream << QString::number(p.x(), 'g', 17) << ' '
+                   << QString::number(p.y(), 'g', 17) << '\n';
+    }
+}
+
+void InputPolygon::bumpVersion() noexcept {
+    static std::atomic<quint64> counter{0};
+    dataVersion = ++counter;
+}
+
+void InputPolygon::clearPolygon() noexcept {
+    outer.clear();
+    holes.clear();
+    bumpVersion();
+}
+
+void InputPolygon::setLoops(const QVector<QPointF>& outerLoop, const QVector<QVector<QPointF>>& holeLoops) {
+    outer = outerLoop;
+    holes = holeLoops;
+    bumpVersion();
+}
+
+bool InputPolygon::loadData(const QString& filePath, QString* error) {
+    clearPolygon();
+
+    QVector<InputPolygon> polys;
+    QVector<QVector<QPointF>> lines;
+    if (!readPolygonFile(filePath, polys, lines, error) || !rejectPolylines(filePath, lines, error)) {
+        return false;
     }
-    flushCurrentLoop();
-    if (outer.isEmpty()) {
+    if (polys.isEmpty()) {
         if (error) {
             *error = QStringLiteral(
                          "ERROR: NO OUTER LOOP FOUND IN FILE %1."
                          ).arg(filePath);
         }
-        clearPolygon();
         return false;
     }
-    qDebug() << "[inputPolygon] outer points:" << outer.size();
-    qDebug() << "[inputPolygon] holes:" << holes.size();
-    for (int i = 0; i < holes.size(); ++i) {
-        qDebug() << "    hole" << i << "points:" << holes[i].size();
+    if (polys.size() > 1) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FILE %1 HOLDS %2 POLYGONS, EXPECTED ONE."
+                         ).arg(filePath).arg(polys.size());
+        }
+        return false;
     }
+    outer = polys[0].outer;
+    holes = polys[0].holes;
+    bumpVersion();
     return true;
 }
+
+bool InputPolygon::loadAll(const QString& filePath, QVector<InputPolygon>& polys, QString* error) {
+    QVector<QVector<QPointF>> lines;
+    if (!readPolygonFile(filePath, polys, lines, error) || !rejectPolylines(filePath, lines, error)) {
+        polys.clear();
+        return false;
+    }
+    return true;
+}
+
+bool InputPolygon::saveData(const QString& filePath, QString* error) const {
+    return saveAll(filePath, QVector<InputPolygon>{ *this }, error);
+}
+
+bool InputPolygon::saveAll(const QString& filePath, const QVector<InputPolygon>& polys, QString* error) {
+    return writeTextFile(filePath, error, [&](QTextStream& textStream) {
+        for (int k = 0; k < polys.size(); ++k) {
+            if (polys.size() > 1) {
+                textStream << "#polygon " << k << '\n';
+            }
+            textStream << "#loop outer\n";
+            writePoints(textStream, polys[k].outer);
+            for (const auto& h : polys[k].holes) {
+                textStream << "#loop hole\n";
+                writePoints(textStream, h);
+            }
+        }
+    });
+}
+
+bool InputPolygon::loadPolylines(const QString& filePath, QVector<QVector<QPointF>>& lines, QString* error) {
+    QVector<InputPolygon> polys;
+    if (!readPolygonFile(filePath, polys, lines, error)) {
+        return false;
+    }
+    if (!polys.isEmpty()) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FILE %1 HOLDS %2 POLYGONS, EXPECTED OPEN POLYLINES."
+                         ).arg(filePath).arg(polys.size());
+        }
+        lines.clear();
+        return false;
+    }
+    return true;
+}
+
+bool InputPolygon::savePolylines(const QString& filePath, const QVector<QVector<QPointF>>& lines, QString* error) {
+    return writeTextFile(filePath, error, [&](QTextStream& textStream) {
+        for (int k = 0; k < lines.size(); ++k) {
+            textStream << "#polyline " << k << '\n';
+            writePoints(textStream, lines[k]);
+        }
+    });
+}
@@ -2,20 +2,39 @@
 #include <QVector>
 #include <QPointF>
 #include <QString>
+#include <QtGlobal>
 
 class InputPolygon {
 public:
     InputPolygon() = default;
     ~InputPolygon() = default;
 
+    // text, or the binary format of polygonfile.h when the file starts with its magic
     bool loadData(const QString& filePath, QString* error = nullptr);
+    bool saveData(const QString& filePath, QString* error = nullptr) const;
+    // Several polygons in one text file, each introduced by a "#polygon"
+    // comment; loadData() rejects such a file. loadAll() also takes a single
+    // polygon file, and a file without loops gives no polygons.
+    static bool loadAll(const QString& filePath, QVector<InputPolygon>& polys, QString* error = nullptr);
+    static bool saveAll(const QString& filePath, const QVector<InputPolygon>& polys, QString* error = nullptr);
+    // Open polylines, each introduced by a "#polyline" comment and never
+    // closed on reading; the polygon loaders reject such a file, and
+    // loadPolylines() rejects one holding polygons.
+    static bool loadPolylines(const QString& filePath, QVector<QVector<QPointF>>& lines, QString* error = nullptr);
+    static bool savePolylines(const QString& filePath, const QVector<QVector<QPointF>>& lines, QString* error = nullptr);
     void clearPolygon() noexcept;
+    void setLoops(const QVector<QPointF>& outerLoop, const QVector<QVector<QPointF>>& holeLoops);
     bool checkEmpty() const noexcept { return outer.isEmpty(); }
     int outerPointCount() const noexcept { return outer.size(); }
     const QVector<QPointF>& outerLoop() const noexcept { return outer; }
     const QVector<QVector<QPointF>>& holeLoops() const noexcept { return holes; }
+    // changes whenever the loops do, unique across all polygons
+    quint64 version() const noexcept { return dataVersion; }
 
 private:
+    void bumpVersion() noexcept;
+
     QVector<QPointF> outer;
     QVector<QVector<QPointF>> holes;
+    quint64 dataVersion = 0;
 };
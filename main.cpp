@@ -1,6 +1,9 @@
 #include <QApplication>
 #include <QScreen>
 #include <QDebug>
+#include <QThreadPool>
+#include <memory>
+#include <utility>
 #include "mainwindow.h"
 #include "inputpolygon.h"
 #include "booleanops.h"
@@ -25,11 +28,41 @@ void initWindow() {
     windowTopLeft = availableArea.center() - QPoint(windowWidth / 2, windowHeight / 2);
 }
 
+// stitched result rings, closed explicitly since the canvas draws results as open polylines
+QVector<QVector<QPointF>> resultLoops(const QVector<QVector<QPointF>>& segments) {
+    QVector<QVector<QPointF>> loops;
+    auto addClosed = [&](QVector<QPointF> loop) {
+        loop.push_back(loop.first());
+        loops.push_back(std::move(loop));
+    };
+    for (const auto& poly : Boolean2D::stitchSegments(segments)) {
+        addClosed(poly.outerLoop());
+        for (const auto& h : poly.holeLoops()) {
+            addClosed(h);
+        }
+    }
+    return loops;
+}
+
+static QString stageName(Geometry::PipelineStage stage) {
+    switch (stage) {
+    case Geometry::PipelineStage::SelfCutsA: return QStringLiteral("self cuts A");
+    case Geometry::PipelineStage::SelfCutsB: return QStringLiteral("self cuts B");
+    case Geometry::PipelineStage::Intersect: return QStringLiteral("intersect");
+    case Geometry::PipelineStage::ExplodeA:  return QStringLiteral("explode A");
+    case Geometry::PipelineStage::ExplodeB:  return QStringLiteral("explode B");
+    case Geometry::PipelineStage::Classify:  return QStringLiteral("classify");
+    }
+    return QString();
+}
+
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
 
     InputPolygon polygonA;
     InputPolygon polygonB;
+    // only ever touched by the job thread, jobs run one at a time
+    auto prepCache = std::make_shared<Boolean2D::PrepCache>();
 
     initParameters();
     initWindow();
@@ -37,9 +70,36 @@ int main(int argc, char *argv[]) {
     MainWindow mainWin(windowWidth, windowHeight, windowTopLeft);
     mainWin.showWindow(windowWidth, windowHeight, windowTopLeft);
 
+    // Operations run on one worker thread, the GUI thread stays responsive.
+    // A job works on its own copies of polygonA/B, which share their data
+    // until the GUI changes them, and on prepCache, which the GUI thread
+    // never touches; so stopJob() only cancels and never waits. Results and
+    // progress come back as queued calls tagged with the job number; stale
+    // ones are dropped.
+    QThreadPool jobPool;
+    jobPool.setMaxThreadCount(1);
+    std::shared_ptr<Geometry::PipelineControl> jobControl;
+    int currentJob = 0;
+    auto stopJob = [&]() {
+        if (jobControl) jobControl->cancel();
+        jobControl.reset();
+        ++currentJob;
+        mainWin.setJobRunning(false);
+    };
+    // frees the prepared inputs once they are stale, queued behind any job still using them
+    auto dropPrep = [&]() {
+        jobPool.start([cache = prepCache]() { cache->invalidate(); });
+    };
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, [&](){
+        stopJob();
+        jobPool.waitForDone();
+    });
+
     QObject::connect(&mainWin, &MainWindow::polygonASelected,
                      [&](const QString& path){
                          qInfo().noquote() << "[main] load A from:" << path;
+                         stopJob();
+                         dropPrep();
                          QString err;
                          if (!polygonA.loadData(path, &err)) {
                              qWarning().noquote() << "[main] Failed to load A:" << err;
@@ -59,6 +119,8 @@ int main(int argc, char *argv[]) {
     QObject::connect(&mainWin, &MainWindow::polygonBSelected,
                      [&](const QString& path){
                          qInfo().noquote() << "[main] load B from:" << path;
+                         stopJob();
+                         dropPrep();
                          QString err;
                          if (!polygonB.loadData(path, &err)) {
                              qWarning().noquote() << "[main] Failed to load B:" << err;
@@ -78,6 +140,8 @@ int main(int argc, char *argv[]) {
     QObject::connect(&mainWin, &MainWindow::polygonACleared,
                      [&](){
                          qInfo().noquote() << "[main] polygonA cleared";
+                         stopJob();
+                         dropPrep();
                          polygonA.clearPolygon();
                          mainWin.clearPolygonAVisual();
                      });
@@ -85,6 +149,8 @@ int main(int argc, char *argv[]) {
     QObject::connect(&mainWin, &MainWindow::polygonBCleared,
                      [&](){
                          qInfo().noquote() << "[main] polygonB cleared";
+                         stopJob();
+                         dropPrep();
                          polygonB.clearPolygon();
                          mainWin.clearPolygonBVisual();
                      });
@@ -92,63 +158,82 @@ int main(int argc, char *argv[]) {
     QObject::connect(&mainWin, &MainWindow::allPolygonsCleared,
                      [&](){
                          qInfo().noquote() << "[main] all polygons cleared";
+                         stopJob();
+                         dropPrep();
                          polygonA.clearPolygon();
                          polygonB.clearPolygon();
                          mainWin.clearAllPolygonsVisual();
                      });
 
+    // POLYBOOL_STATS=1 logs stage timings and counters after every operation
+    const bool logStats = qEnvironmentVariableIsSet("POLYBOOL_STATS");
+    using ComputeFn = QVector<QVector<QPointF>> (*)(const Boolean2D::PrepContext&, const InputPolygon&, const InputPolygon&);
+    auto runOperation = [&](const char* name, ComputeFn compute) {
+        if (polygonA.outerLoop().isEmpty() || polygonB.outerLoop().isEmpty()) {
+            qWarning().noquote() << "Need Two Polygons";
+            return;
+        }
+        stopJob();
+        qInfo().noquote() << "[main]" << name << "now running";
+        const int id = currentJob;
+        jobControl = std::make_shared<Geometry::PipelineControl>(
+            [&mainWin, &currentJob, id](Geometry::PipelineStage stage, double fraction) {
+                QMetaObject::invokeMethod(&mainWin, [&mainWin, &currentJob, id, stage, fraction]() {
+                    if (id == currentJob) mainWin.setJobProgress(stageName(stage), int(100.0 * fraction));
+                }, Qt::QueuedConnection);
+            });
+        mainWin.setJobRunning(true);
+        jobPool.start([&mainWin, &currentJob, logStats, name, compute, id, control = jobControl,
+                       cache = prepCache, polyA = polygonA, polyB = polygonB]() {
+            Geometry::PipelineStats stats;
+            QVector<QVector<QPointF>> loops;
+            if (!control->isCanceled()) {
+                Geometry::ControlScope controlScope(control.get());
+                Geometry::StatsScope scope(logStats ? &stats : nullptr);
+                const auto& ctx = cache->get(polyA, polyB, 1e-3, 1e-9);
+                if (!control->isCanceled()) {
+                    auto resSegments = compute(ctx, polyA, polyB);
+                    if (!control->isCanceled()) loops = resultLoops(resSegments);
+                }
+            }
+            if (control->isCanceled()) {
+                qInfo().noquote() << "[main]" << name << "canceled";
+                return;
+            }
+            if (logStats) {
+                qInfo().noquote() << "[main]" << name << (cache->lastWasHit() ? "prep cached |" : "prep ran |") << stats.summary();
+            }
+            QMetaObject::invokeMethod(&mainWin, [&mainWin, &currentJob, id, loops = std::move(loops)]() mutable {
+                if (id != currentJob) return;
+                mainWin.setCanvasPolygons(std::move(loops));
+                mainWin.setJobRunning(false);
+            }, Qt::QueuedConnection);
+        });
+    };
+
     QObject::connect(&mainWin, &MainWindow::requestAddition,
-                     [&](){
-                         if (polygonA.outerLoop().isEmpty() || polygonB.outerLoop().isEmpty()) {
-                             qWarning().noquote() << "Need Two Polygons";
-                             return;
-                         }
-                         qInfo().noquote() << "[main] Addition() now running";
-                         auto ctx = Boolean2D::prepare(polygonA, polygonB, 1e-3, 1e-9);
-                         auto resSegments = Boolean2D::computeAdditionSegments(ctx, polygonA, polygonB);
-                         mainWin.setCanvasPolygons(resSegments);
-                     });
+                     [&](){ runOperation("Addition()", Boolean2D::computeAdditionSegments); });
 
     QObject::connect(&mainWin, &MainWindow::requestIntersection,
-                     [&](){
-                         if (polygonA.outerLoop().isEmpty() || polygonB.outerLoop().isEmpty()) {
-                             qWarning().noquote() << "Need Two Polygons";
-                             return;
-                         }
-                         qInfo().noquote() << "[main] Intersection() now running";
-                         auto ctx = Boolean2D::prepare(polygonA, polygonB, 1e-3, 1e-9);
-                         auto resSegments = Boolean2D::computeIntersectionSegments(ctx, polygonA, polygonB);
-                         mainWin.setCanvasPolygons(resSegments);
-                     });
+                     [&](){ runOperation("Intersection()", Boolean2D::computeIntersectionSegments); });
 
     QObject::connect(&mainWin, &MainWindow::requestSubtractionAB,
-                     [&](){
-                         if (polygonA.outerLoop().isEmpty() || polygonB.outerLoop().isEmpty()) {
-                             qWarning().noquote() << "Need Two Polygons";
-                             return;
-                         }
-                         qInfo().noquote() << "[main] Subtraction(A-B) now running";
-                         auto ctx = Boolean2D::prepare(polygonA, polygonB, 1e-3, 1e-9);
-                         auto resSegments = Boolean2D::computeSubtractionABSegments(ctx, polygonA, polygonB);
-                         mainWin.setCanvasPolygons(resSegments);
-                     });
+                     [&](){ runOperation("Subtraction(A-B)", Boolean2D::computeSubtractionABSegments); });
 
     QObject::connect(&mainWin, &MainWindow::requestSubtractionBA,
-                     [&](){
-                         if (polygonA.outerLoop().isEmpty() || polygonB.outerLoop().isEmpty()) {
-                             qWarning().noquote() << "Need Two Polygons";
-                             return;
-                         }
-                         qInfo().noquote() << "[main] Subtraction(B-A) now running";
-                         auto ctx = Boolean2D::prepare(polygonA, polygonB, 1e-3, 1e-9);
-                         auto resSegments = Boolean2D::computeSubtractionBASegments(ctx, polygonA, polygonB);
-                         mainWin.setCanvasPolygons(resSegments);
-                     });
+                     [&](){ runOperation("Subtraction(B-A)", Boolean2D::computeSubtractionBASegments); });
 
     QObject::connect(&mainWin, &MainWindow::requestReset,
                      [&](){
+                         stopJob();
                          qInfo().noquote() << "[main] Reset() should run here";
                      });
 
+    QObject::connect(&mainWin, &MainWindow::requestCancel,
+                     [&](){
+                         qInfo().noquote() << "[main] canceling the running operation";
+                         stopJob();
+                     });
+
     return app.exec();
 }
@@ -9,9 +9,11 @@
 #include <QStandardPaths>
 #include <QFileDialog>
 #include <QStatusBar>
+#include <QProgressBar>
 #include <QFileInfo>
 #include <QtGlobal>
 #include <QDebug>
+#include <utility>
 
 void MainWindow::initSplitter(QWidget* left, QWidget* right) {
     windowSplitter = new QSplitter(Qt::Horizontal, this);
@@ -266,6 +268,32 @@ void MainWindow::setCanvasPolygons(const QVector<QVector<QPointF>>& loops) {
     }
 }
 
+void MainWindow::setCanvasPolygons(QVector<QVector<QPointF>>&& loops) {
+    if (rightPart) {
+        rightPart->setResultSegments(std::move(loops));
+    }
+}
+
+void MainWindow::setJobRunning(bool running) {
+    jobProgress->setValue(0);
+    jobProgress->setFormat(QStringLiteral("%p%"));
+    jobProgress->setVisible(running);
+    jobCancel->setVisible(running);
+    jobCancel->setEnabled(running);
+}
+
+void MainWindow::setJobProgress(const QString& stage, int percent) {
+    jobProgress->setFormat(tr("%1 %p%").arg(stage));
+    jobProgress->setValue(percent);
+}
+
+void MainWindow::onCancelClicked() {
+    qInfo().noquote() << "[UI] Cancel requested";
+    statusBar()->showMessage(tr("Canceling..."), 2000);
+    jobCancel->setEnabled(false);
+    emit requestCancel();
+}
+
 void MainWindow::onClearPolygonA() {
     currentFilePathA.clear();
     qInfo().noquote() << "[UI] Polygon A cleared";
@@ -354,6 +382,15 @@ MainWindow::MainWindow(int windowWidth, int windowHeight, QPoint windowTopLeft,
     initPane(leftPart, rightPart);
     initSplitter(leftPart, rightPart);
     initLeftPanelUI(leftPart);
+
+    jobProgress = new QProgressBar(this);
+    jobProgress->setRange(0, 100);
+    jobProgress->setMaximumWidth(260);
+    jobCancel = new QPushButton(tr("Cancel"), this);
+    connect(jobCancel, &QPushButton::clicked, this, &MainWindow::onCancelClicked);
+    statusBar()->addPermanentWidget(jobProgress);
+    statusBar()->addPermanentWidget(jobCancel);
+    setJobRunning(false);
 }
 
 MainWindow::~MainWindow() {
@@ -6,6 +6,8 @@
 
 class QSplitter;
 class QWidget;
+class QProgressBar;
+class QPushButton;
 class Canvas2D;
 
 class MainWindow : public QMainWindow {
@@ -21,10 +23,15 @@ public:
     void setPolygonAVisual(const QVector<QVector<QPointF>>& loops);
     void setPolygonBVisual(const QVector<QVector<QPointF>>& loops);
     void setCanvasPolygons(const QVector<QVector<QPointF>>& loops);
+    void setCanvasPolygons(QVector<QVector<QPointF>>&& loops);
     void clearPolygonAVisual();
     void clearPolygonBVisual();
     void clearAllPolygonsVisual();
 
+    // progress bar and cancel button in the status bar while a job runs
+    void setJobRunning(bool running);
+    void setJobProgress(const QString& stage, int percent);
+
 signals:
     void polygonASelected(const QString& path);
     void polygonBSelected(const QString& path);
@@ -38,6 +45,7 @@ signals:
     void requestSubtractionAB();
     void requestSubtractionBA();
     void requestReset();
+    void requestCancel();
 
 private slots:
     void onReadPolygonA();
@@ -51,6 +59,7 @@ private slots:
     void onSubtractionABClicked();
     void onSubtractionBAClicked();
     void onResetClicked();
+    void onCancelClicked();
 
 private:
     void initSplitter(QWidget* left, QWidget* right);
@@ -62,6 +71,9 @@ private:
     QWidget*   leftPart       = nullptr;
     Canvas2D*  rightPart      = nullptr;
 
+    QProgressBar* jobProgress = nullptr;
+    QPushButton*  jobCancel   = nullptr;
+
     QString currentFilePathA;
     QString currentFilePathB;
 };
@@ -0,0 +1,334 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QDebug>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include "inputpolygon.h"
+#include "geometrymodel.h"
+#include "booleanops.h"
+#include "pointlocator.h"
+#include "segmentkernel.h"
+
+// Runs every case through each candidate mode, thread count and classifier,
+// also with A prepared, and requires the atoms every operation keeps to match
+// the serial brute-force run with point tests exactly. The reference run is
+// repeated in a child process with POLYBOOL_SIMD=scalar, whose digest must
+// match this one. Exits with 1 on any difference, for ctest.
+
+struct ModeCase {
+    QString      name;
+    InputPolygon polyA;
+    InputPolygon polyB;
+    bool         repeats = false; // loops repeat vertices, point location is also checked without them
+};
+
+struct Variant {
+    QString                  name;
+    Geometry::AtomizeOptions opts;
+    bool                     propagate = false;
+    bool                     prepared  = false;
+};
+
+static const double kEpsGeom  = 1e-3;
+static const double kEpsParam = 1e-9;
+
+static const QPair<const char*, Boolean2D::Operation> kOperations[] = {
+    {"addition",     Boolean2D::Operation::Addition},
+    {"intersection", Boolean2D::Operation::Intersection},
+    {"subAB",        Boolean2D::Operation::SubAB},
+    {"subBA",        Boolean2D::Operation::SubBA},
+};
+
+static QVector<QPointF> rectLoop(double x0, double y0, double x1, double y1, bool clockwise) {
+    if (clockwise) {
+        return {QPointF(x0, y0), QPointF(x0, y1), QPointF(x1, y1), QPointF(x1, y0)};
+    }
+    return {QPointF(x0, y0), QPointF(x1, y0), QPointF(x1, y1), QPointF(x0, y1)};
+}
+
+// random stars with a square hole, vertices snapped to a coarse grid so
+// many edges of A and B overlap collinearly
+static QVector<ModeCase> makeStars(std::mt19937& rng) {
+    const int n = 300;
+    std::uniform_real_distribution<double> radius(60.0, 100.0);
+    auto star = [&](double cx, double cy, double snap) {
+        QVector<QPointF> pts;
+        pts.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            const double a = 2.0 * std::numbers::pi * i / n;
+            const double r = radius(rng);
+            double x = cx + r * std::cos(a);
+            double y = cy + r * std::sin(a);
+            if (snap > 0.0) {
+                x = std::round(x / snap) * snap;
+                y = std::round(y / snap) * snap;
+            }
+            pts.push_back(QPointF(x, y));
+        }
+        return pts;
+    };
+    QVector<ModeCase> cases;
+    for (double snap : {0.0, 4.0}) {
+        ModeCase c;
+        c.name = snap > 0.0 ? "stars/snapped" : "stars";
+        c.polyA.setLoops(star(0.0, 0.0, snap), {rectLoop(-20.0, -20.0, 20.0, 20.0, true)});
+        c.polyB.setLoops(star(16.0, 8.0, snap), {rectLoop(-4.0, -12.0, 36.0, 28.0, true)});
+        cases.push_back(c);
+    }
+    ModeCase same;
+    same.name = "stars/same";
+    same.polyA = cases.front().polyA;
+    same.polyB = cases.front().polyA;
+    cases.push_back(same);
+    return cases;
+}
+
+// squares sharing a whole edge and half an edge
+static QVector<ModeCase> makeSharedEdges(std::mt19937&) {
+    ModeCase whole;
+    whole.name = "shared/whole";
+    whole.polyA.setLoops(rectLoop(0.0, 0.0, 10.0, 10.0, false), {});
+    whole.polyB.setLoops(rectLoop(10.0, 0.0, 20.0, 10.0, false), {});
+    ModeCase half;
+    half.name = "shared/half";
+    half.polyA.setLoops(rectLoop(0.0, 0.0, 10.0, 10.0, false), {});
+    half.polyB.setLoops(rectLoop(10.0, 5.0, 20.0, 15.0, false), {});
+    ModeCase hole;
+    hole.name = "shared/hole";
+    hole.polyA.setLoops(rectLoop(0.0, 0.0, 30.0, 30.0, false), {rectLoop(10.0, 10.0, 20.0, 20.0, true)});
+    hole.polyB.setLoops(rectLoop(10.0, 10.0, 20.0, 20.0, false), {});
+    return {whole, half, hole};
+}
+
+// overlapping rectangles whose top and bottom edges are collinear, A's
+// edges split by extra collinear vertices
+static QVector<ModeCase> makeCollinear(std::mt19937&) {
+    ModeCase c;
+    c.name = "collinear";
+    c.polyA.setLoops({QPointF(0.0, 0.0), QPointF(3.0, 0.0), QPointF(7.0, 0.0), QPointF(12.0, 0.0),
+                      QPointF(12.0, 10.0), QPointF(5.0, 10.0), QPointF(0.0, 10.0)}, {});
+    c.polyB.setLoops(rectLoop(5.0, 0.0, 20.0, 10.0, false), {});
+    ModeCase inside;
+    inside.name = "collinear/inside";
+    inside.polyA.setLoops(rectLoop(0.0, 0.0, 20.0, 10.0, false), {});
+    inside.polyB.setLoops(rectLoop(5.0, 0.0, 15.0, 10.0, false), {});
+    return {c, inside};
+}
+
+// repeated vertices, so both loops carry zero-length edges
+static QVector<ModeCase> makeZeroLength(std::mt19937&) {
+    ModeCase c;
+    c.name = "zerolength";
+    c.repeats = true;
+    c.polyA.setLoops({QPointF(0.0, 0.0), QPointF(0.0, 0.0), QPointF(10.0, 0.0), QPointF(10.0, 10.0),
+                      QPointF(10.0, 10.0), QPointF(10.0, 10.0), QPointF(0.0, 10.0)}, {});
+    c.polyB.setLoops({QPointF(5.0, 5.0), QPointF(15.0, 5.0), QPointF(15.0, 5.0), QPointF(15.0, 15.0),
+                      QPointF(5.0, 15.0), QPointF(5.0, 15.0)}, {});
+    ModeCase touch;
+    touch.name = "zerolength/shared";
+    touch.repeats = true;
+    touch.polyA = c.polyA;
+    touch.polyB.setLoops({QPointF(10.0, 0.0), QPointF(20.0, 0.0), QPointF(20.0, 10.0), QPointF(10.0, 10.0),
+                          QPointF(10.0, 10.0)}, {});
+    return {c, touch};
+}
+
+static QVector<QPointF> dropRepeats(const QVector<QPointF>& loop) {
+    QVector<QPointF> out;
+    for (const QPointF& p : loop) {
+        if (out.isEmpty() || out.last() != p) out.push_back(p);
+    }
+    while (out.size() > 1 && out.last() == out.first()) out.pop_back();
+    return out;
+}
+
+static InputPolygon withoutRepeats(const InputPolygon& poly) {
+    QVector<QVector<QPointF>> holes;
+    for (const auto& h : poly.holeLoops()) holes.push_back(dropRepeats(h));
+    InputPolygon out;
+    out.setLoops(dropRepeats(poly.outerLoop()), holes);
+    return out;
+}
+
+static QVector<Variant> makeVariants() {
+    const QPair<const char*, Geometry::IntersectMode> modes[] = {
+        {"brute", Geometry::IntersectMode::BruteForce},
+        {"sweep", Geometry::IntersectMode::SweepLine},
+        {"grid",  Geometry::IntersectMode::GridIndex},
+        {"rtree", Geometry::IntersectMode::RTreeIndex},
+    };
+    QVector<Variant> variants;
+    for (const auto& m : modes) {
+        for (int threads : {1, 4}) {
+            for (bool propagate : {false, true}) {
+                for (bool prepared : {false, true}) {
+                    Variant v;
+                    v.name = QString("%1/threads=%2/%3%4").arg(m.first).arg(threads)
+                                 .arg(propagate ? "propagate" : "pointtests")
+                                 .arg(prepared ? "/prepared" : "");
+                    v.opts.mode = m.second;
+                    v.opts.threads = threads;
+                    v.propagate = propagate;
+                    v.prepared = prepared;
+                    variants.push_back(v);
+                }
+            }
+        }
+    }
+    return variants;
+}
+
+static void runVariant(const ModeCase& c, const Variant& v, Boolean2D::Operation op,
+                       QVector<Geometry::AtomicSegment>& out) {
+    Boolean2D::Engine engine;
+    engine.setClassifyMode(v.propagate ? Boolean2D::ClassifyMode::Propagate : Boolean2D::ClassifyMode::PointTests);
+    if (v.prepared) {
+        const Boolean2D::PreparedPolygon preparedA(c.polyA, kEpsGeom, kEpsParam, v.opts);
+        engine.run(op, preparedA, c.polyB, out, v.opts);
+    } else {
+        engine.run(op, c.polyA, c.polyB, out, kEpsGeom, kEpsParam, v.opts);
+    }
+}
+
+// the link only records how the status was found, it is not compared
+static bool sameAtoms(const QVector<Geometry::AtomicSegment>& a, const QVector<Geometry::AtomicSegment>& b) {
+    if (a.size() != b.size()) return false;
+    for (qsizetype i = 0; i < a.size(); ++i) {
+        if (a[i].p0 != b[i].p0 || a[i].p1 != b[i].p1 || a[i].fromA != b[i].fromA
+            || a[i].coincidentWithOther != b[i].coincidentWithOther) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the locator must answer alike with and without the repeated vertices,
+// sampled on a half-unit grid that also hits every boundary
+static bool sameLocation(const InputPolygon& poly) {
+    const Boolean2D::PointLocator withRepeats(poly);
+    const Boolean2D::PointLocator plain(withoutRepeats(poly));
+    double x0 = 0.0, y0 = 0.0, x1 = 0.0, y1 = 0.0;
+    for (const QPointF& p : poly.outerLoop()) {
+        x0 = qMin(x0, p.x()); y0 = qMin(y0, p.y());
+        x1 = qMax(x1, p.x()); y1 = qMax(y1, p.y());
+    }
+    for (double x = x0 - 2.0; x <= x1 + 2.0; x += 0.5) {
+        for (double y = y0 - 2.0; y <= y1 + 2.0; y += 0.5) {
+            if (withRepeats.contains(QPointF(x, y)) != plain.contains(QPointF(x, y))) return false;
+        }
+    }
+    return true;
+}
+
+// FNV-1a over the exact coordinate bits
+static void hashAtoms(const QVector<Geometry::AtomicSegment>& atoms, quint64& h) {
+    auto mix = [&h](const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    for (const auto& s : atoms) {
+        const double v[4] = {s.p0.x(), s.p0.y(), s.p1.x(), s.p1.y()};
+        const unsigned char flags = (s.fromA ? 1 : 0) | (s.coincidentWithOther ? 2 : 0);
+        mix(v, sizeof(v));
+        mix(&flags, 1);
+    }
+    const qsizetype n = atoms.size();
+    mix(&n, sizeof(n));
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("polybool_modetests");
+    const bool digestOnly = app.arguments().contains("--digest");
+
+    using Generator = QVector<ModeCase> (*)(std::mt19937&);
+    const Generator generators[] = {makeStars, makeSharedEdges, makeCollinear, makeZeroLength};
+
+    std::mt19937 rng(1);
+    QVector<ModeCase> cases;
+    for (Generator gen : generators) {
+        cases += gen(rng);
+    }
+    const QVector<Variant> variants = makeVariants();
+    const Variant& reference = variants.front();
+
+    quint64 digest = 14695981039346656037ull;
+    int failures = 0;
+    int checks = 0;
+    QVector<Geometry::AtomicSegment> expected, got;
+    for (const ModeCase& c : cases) {
+        if (c.repeats && !digestOnly) {
+            for (const InputPolygon* poly : {&c.polyA, &c.polyB}) {
+                ++checks;
+                if (!sameLocation(*poly)) {
+                    qWarning().noquote() << "[modetests]" << c.name
+                                         << "point location differs without the repeated vertices";
+                    ++failures;
+                }
+            }
+        }
+        for (const auto& op : kOperations) {
+            runVariant(c, reference, op.second, expected);
+            hashAtoms(expected, digest);
+            if (digestOnly) continue;
+            ++checks;
+            for (const auto& s : expected) {
+                if (s.p0.x() == s.p1.x() && s.p0.y() == s.p1.y()) {
+                    qWarning().noquote() << "[modetests]" << c.name << op.first << "keeps a zero-length atom";
+                    ++failures;
+                    break;
+                }
+            }
+            for (qsizetype v = 1; v < variants.size(); ++v) {
+                runVariant(c, variants[v], op.second, got);
+                ++checks;
+                if (!sameAtoms(expected, got)) {
+                    qWarning().noquote() << "[modetests]" << c.name << op.first << variants[v].name
+                                         << "differs from" << reference.name << "atoms:" << got.size()
+                                         << "expected:" << expected.size();
+                    ++failures;
+                }
+            }
+        }
+    }
+    const QString digestText = QString::number(digest, 16);
+
+    if (digestOnly) {
+        QFile out;
+        if (!out.open(stdout, QIODevice::WriteOnly)) return 3;
+        out.write(digestText.toLatin1() + '\n');
+        return 0;
+    }
+
+    // the SIMD level is read once per process, so the scalar run needs its own
+    const QString level = Geometry::simdLevelName(Geometry::simdLevel());
+    if (level != "scalar") {
+        QProcess child;
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("POLYBOOL_SIMD", "scalar");
+        child.setProcessEnvironment(env);
+        child.start(QCoreApplication::applicationFilePath(), {"--digest"});
+        ++checks;
+        if (!child.waitForFinished(-1) || child.exitCode() != 0) {
+            qWarning().noquote() << "[modetests] scalar run failed:" << child.errorString();
+            ++failures;
+        } else {
+            const QString scalarDigest = QString::fromLatin1(child.readAllStandardOutput()).trimmed();
+            if (scalarDigest != digestText) {
+                qWarning().noquote() << "[modetests] scalar digest" << scalarDigest << "differs from" << level
+                                     << "digest" << digestText;
+                ++failures;
+            }
+        }
+    }
+
+    qInfo().noquote() << "[modetests]" << cases.size() << "cases," << checks << "checks," << failures
+                      << "failures, simd:" << level << "digest:" << digestText;
+    return failures == 0 ? 0 : 1;
+}
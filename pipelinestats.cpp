@@ -0,0 +1,100 @@
+#include "pipelinestats.h"
+
+#include <algorithm>
+
+namespace Geometry {
+
+static thread_local PipelineStats* t_activeStats = nullptr;
+static thread_local PipelineControl* t_activeControl = nullptr;
+
+PipelineStats& PipelineStats::operator+=(const PipelineStats& o) noexcept {
+    rawEdgesNs     += o.rawEdgesNs;
+    selfCutsNs     += o.selfCutsNs;
+    intersectNs    += o.intersectNs;
+    explodeNs      += o.explodeNs;
+    locatorNs      += o.locatorNs;
+    classifyNs     += o.classifyNs;
+    rawEdges       += o.rawEdges;
+    selfPairs      += o.selfPairs;
+    candidatePairs += o.candidatePairs;
+    boxRejected    += o.boxRejected;
+    kernelRejected += o.kernelRejected;
+    pointHits      += o.pointHits;
+    overlapHits    += o.overlapHits;
+    cutParamsRaw   += o.cutParamsRaw;
+    cutParamsKept  += o.cutParamsKept;
+    atoms          += o.atoms;
+    pipCalls       += o.pipCalls;
+    atomsKept      += o.atomsKept;
+    return *this;
+}
+
+QString PipelineStats::summary() const {
+    auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 3); };
+    auto pct = [this](qint64 n) {
+        return QString::number(candidatePairs > 0 ? 100.0 * n / candidatePairs : 0.0, 'f', 1);
+    };
+    return QString("edges %1, self pairs %2, pairs %3 (box -%4%, kernel -%5%), point %6, overlap %7,"
+                   " cuts %8 -> %9, atoms %10, pip %11, kept %12")
+               .arg(rawEdges).arg(selfPairs).arg(candidatePairs).arg(pct(boxRejected), pct(kernelRejected))
+               .arg(pointHits).arg(overlapHits).arg(cutParamsRaw).arg(cutParamsKept).arg(atoms)
+               .arg(pipCalls).arg(atomsKept)
+        + QString(" | ms: edges %1, self %2, intersect %3, explode %4, locator %5, classify %6")
+              .arg(ms(rawEdgesNs), ms(selfCutsNs), ms(intersectNs), ms(explodeNs), ms(locatorNs), ms(classifyNs));
+}
+
+StatsScope::StatsScope(PipelineStats* sink) noexcept
+    : prev_(t_activeStats) {
+    t_activeStats = sink;
+}
+
+StatsScope::~StatsScope() {
+    t_activeStats = prev_;
+}
+
+PipelineStats* activeStats() noexcept {
+    return t_activeStats;
+}
+
+void PipelineControl::report(PipelineStage stage, double fraction) {
+    if (!onProgress_) return;
+    const int percent = int(100.0 * std::clamp(fraction, 0.0, 1.0));
+    const int step = int(stage) * 101 + percent;
+    int last = lastStep_.load(std::memory_order_relaxed);
+    do {
+        if (step <= last) return;
+    } while (!lastStep_.compare_exchange_weak(last, step, std::memory_order_relaxed));
+    onProgress_(stage, percent / 100.0);
+}
+
+ControlScope::ControlScope(PipelineControl* control) noexcept
+    : prev_(t_activeControl) {
+    t_activeControl = control;
+}
+
+ControlScope::~ControlScope() {
+    t_activeControl = prev_;
+}
+
+PipelineControl* activeControl() noexcept {
+    return t_activeControl;
+}
+
+bool cancelRequested() noexcept {
+    return t_activeControl && t_activeControl->isCanceled();
+}
+
+void reportProgress(PipelineStage stage, double fraction) {
+    if (t_activeControl) t_activeControl->report(stage, fraction);
+}
+
+StageTimer::StageTimer(qint64 PipelineStats::*field) noexcept
+    : stats_(t_activeStats), field_(field) {
+    if (stats_) timer_.start();
+}
+
+StageTimer::~StageTimer() {
+    if (stats_) stats_->*field_ += timer_.nsecsElapsed();
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <utility>
+
+namespace Geometry {
+
+// Wall time and counters of the boolean pipeline. The hooks write to the
+// stats of the innermost StatsScope on the calling thread; with no scope open
+// each hook costs a thread-local load and a branch.
+struct PipelineStats {
+    // wall time per stage, nanoseconds
+    qint64 rawEdgesNs  = 0;
+    qint64 selfCutsNs  = 0;
+    qint64 intersectNs = 0;
+    qint64 explodeNs   = 0;
+    qint64 locatorNs   = 0;
+    qint64 classifyNs  = 0;
+
+    qint64 rawEdges       = 0;
+    qint64 selfPairs      = 0; // same-polygon pairs tested by the self pass
+    qint64 candidatePairs = 0; // A x B pairs considered
+    qint64 boxRejected    = 0; // dropped by the padded box pre-pass (brute force)
+    qint64 kernelRejected = 0; // dropped by the batched segment pre-test
+    qint64 pointHits      = 0;
+    qint64 overlapHits    = 0;
+    qint64 cutParamsRaw   = 0; // before dedup
+    qint64 cutParamsKept  = 0; // after dedup
+    qint64 atoms          = 0;
+    qint64 pipCalls       = 0; // point-in-polygon queries of the classifiers
+    qint64 atomsKept      = 0;
+
+    PipelineStats& operator+=(const PipelineStats& o) noexcept;
+    QString summary() const;
+};
+
+// Collects into *sink until destroyed, nullptr switches collection off.
+// Scopes nest; the previous sink is restored on exit.
+class StatsScope {
+public:
+    explicit StatsScope(PipelineStats* sink) noexcept;
+    ~StatsScope();
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+private:
+    PipelineStats* prev_;
+};
+
+PipelineStats* activeStats() noexcept;
+
+// stages that report progress, in the order a run passes them
+enum class PipelineStage : quint8 {
+    SelfCutsA,
+    SelfCutsB,
+    Intersect,
+    ExplodeA,
+    ExplodeB,
+    Classify
+};
+
+// Progress and cooperative cancellation of one run. The stages report into
+// the control of the innermost ControlScope on the calling thread and poll it
+// at checkpoints; once canceled they return early, leaving partial output for
+// the caller to discard. cancel() may be called from any thread.
+class PipelineControl {
+public:
+    // called on the reporting thread, which may be a worker of the A x B pass
+    using ProgressFn = std::function<void(PipelineStage stage, double fraction)>;
+
+    explicit PipelineControl(ProgressFn onProgress = ProgressFn()) : onProgress_(std::move(onProgress)) {}
+
+    void cancel() noexcept { canceled_.store(true, std::memory_order_relaxed); }
+    bool isCanceled() const noexcept { return canceled_.load(std::memory_order_relaxed); }
+
+    // fraction of stage done; forwarded in whole percent steps, never backwards
+    void report(PipelineStage stage, double fraction);
+
+private:
+    ProgressFn        onProgress_;
+    std::atomic<bool> canceled_{false};
+    std::atomic<int>  lastStep_{-1}; // stage * 101 + percent
+};
+
+class ControlScope {
+public:
+    explicit ControlScope(PipelineControl* control) noexcept;
+    ~ControlScope();
+    ControlScope(const ControlScope&) = delete;
+    ControlScope& operator=(const ControlScope&) = delete;
+
+private:
+    PipelineControl* prev_;
+};
+
+PipelineControl* activeControl() noexcept;
+
+// checkpoint hooks, a thread-local load and a branch without a control
+bool cancelRequested() noexcept;
+void reportProgress(PipelineStage stage, double fraction);
+
+// adds the lifetime of the object to one time field of the active stats
+class StageTimer {
+public:
+    explicit StageTimer(qint64 PipelineStats::*field) noexcept;
+    ~StageTimer();
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    PipelineStats* stats_;
+    qint64 PipelineStats::*field_;
+    QElapsedTimer timer_;
+};
+
+}
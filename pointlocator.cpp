@@ -0,0 +1,152 @@
+#include "pointlocator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Boolean2D {
+
+PointLocator::PointLocator(const InputPolygon& poly, double eps) {
+    build(poly, eps);
+}
+
+// loopEdges(edge) calls edge(a, b, loop) for every edge, loops in order with
+// the outer loop as 0 and the holes from 1
+template<class LoopEdges>
+void PointLocator::buildBuckets(int loopCount, double eps, LoopEdges&& loopEdges) {
+    eps_ = eps;
+    bucketStart_.clear();
+    for (QVector<double>* v : { &ax_, &ay_, &by_, &dx_, &dy_ }) v->clear();
+    loop_.clear();
+    buckets_ = 0;
+    loopCount_ = loopCount;
+
+    // fn(a, b, loop, lo, hi) per edge, y-range padded by the reach of the on-edge
+    // test (|cross| < eps and dot in [-eps, |ab|^2 + eps] reach about eps / |ab|);
+    // the passes re-walk the loops so a rebuild allocates nothing new; a
+    // zero-length edge is skipped, its point is on the neighbouring edges
+    auto forEachEdge = [&](auto&& fn) {
+        loopEdges([&](const QPointF& a, const QPointF& b, int l) {
+            const double len = std::hypot(b.x() - a.x(), b.y() - a.y());
+            if (len == 0.0) return;
+            const double pad = 1.01 * (2.0 * eps / len + eps);
+            fn(a, b, l, std::min(a.y(), b.y()) - pad, std::max(a.y(), b.y()) + pad);
+        });
+    };
+    int edgeCount = 0;
+    double maxY = 0.0;
+    double span = 0.0;
+    forEachEdge([&](const QPointF&, const QPointF&, int, double lo, double hi) {
+        minY_ = (edgeCount == 0) ? lo : std::min(minY_, lo);
+        maxY  = (edgeCount == 0) ? hi : std::max(maxY, hi);
+        span += hi - lo;
+        ++edgeCount;
+    });
+    if (edgeCount == 0) return;
+
+    const double H = maxY - minY_;
+    // about one bucket per edge, fewer when long edges would be copied into many
+    const double relSpan = (H > 0.0) ? span / H : edgeCount;
+    const double n = edgeCount;
+    buckets_ = int(std::clamp(3.0 * n / std::max(1.0, relSpan), 1.0, n));
+    bucketH_ = (H > 0.0) ? H / buckets_ : 1.0;
+
+    auto bucketOf = [&](double y) {
+        return std::clamp(int((y - minY_) / bucketH_), 0, buckets_ - 1);
+    };
+    bucketStart_.fill(0, buckets_ + 1);
+    forEachEdge([&](const QPointF&, const QPointF&, int, double lo, double hi) {
+        for (int b = bucketOf(lo); b <= bucketOf(hi); ++b) ++bucketStart_[b + 1];
+    });
+    for (int b = 0; b < buckets_; ++b) bucketStart_[b + 1] += bucketStart_[b];
+    const int entries = bucketStart_.last();
+    for (QVector<double>* v : { &ax_, &ay_, &by_, &dx_, &dy_ }) v->resize(entries);
+    loop_.resize(entries);
+    // bucketStart_ serves as the write cursor, afterwards entry b holds the start of b + 1
+    forEachEdge([&](const QPointF& a, const QPointF& b, int loop, double lo, double hi) {
+        for (int k = bucketOf(lo); k <= bucketOf(hi); ++k) {
+            const int slot = bucketStart_[k]++;
+            ax_[slot]   = a.x();
+            ay_[slot]   = a.y();
+            by_[slot]   = b.y();
+            dx_[slot]   = b.x() - a.x();
+            dy_[slot]   = b.y() - a.y();
+            loop_[slot] = loop;
+        }
+    });
+    for (int k = buckets_; k > 0; --k) bucketStart_[k] = bucketStart_[k - 1];
+    bucketStart_[0] = 0;
+}
+
+void PointLocator::build(const InputPolygon& poly, double eps) {
+    const int loopCount = 1 + poly.holeLoops().size();
+    buildBuckets(loopCount, eps, [&](auto&& edge) {
+        for (int l = 0; l < loopCount; ++l) {
+            const QVector<QPointF>& loop = (l == 0) ? poly.outerLoop() : poly.holeLoops()[l - 1];
+            const int n = loop.size();
+            if (n < 3) continue;
+            for (int i = 0; i < n; ++i) edge(loop[i], loop[(i+1) % n], l);
+        }
+    });
+}
+
+void PointLocator::build(const Geometry::PolygonTopo& topo, double eps) {
+    int holes = 0;
+    for (const auto& loop : topo.loops) holes += loop.isHole ? 1 : 0;
+    buildBuckets(1 + holes, eps, [&](auto&& edge) {
+        int hole = 0;
+        for (const auto& loop : topo.loops) {
+            const int l = loop.isHole ? ++hole : 0;
+            const QVector<int>& lv = loop.loopVertices;
+            const int n = lv.size();
+            if (n < 3) continue;
+            for (int i = 0; i < n; ++i) edge(topo.verts[lv[i]].pos, topo.verts[lv[(i+1) % n]].pos, l);
+        }
+    });
+}
+
+bool PointLocator::containsInBucket(int bucket, const QPointF& p) const {
+    const double eps = eps_;
+    const int end = bucketStart_[bucket + 1];
+    int k = bucketStart_[bucket];
+    bool inOuter = false;
+    const double px = p.x();
+    const double py = p.y();
+    while (k < end) {
+        const int loop = loop_[k];
+        bool onEdge = false;
+        bool inside = false;
+        for (; k < end && loop_[k] == loop; ++k) {
+            const double apx = px - ax_[k];
+            const double apy = py - ay_[k];
+            const double abx = dx_[k];
+            const double aby = dy_[k];
+            const double cross = apx * aby - apy * abx;
+            if (std::fabs(cross) < eps) {
+                const double dot = apx * abx + apy * aby;
+                if (dot >= -eps && dot <= abx * abx + aby * aby + eps) onEdge = true;
+            }
+            if ((ay_[k] > py) != (by_[k] > py)) {
+                const double t = (py - ay_[k]) / aby;
+                const double xHit = ax_[k] + t * abx;
+                if (xHit >= px - eps) inside = !inside;
+            }
+        }
+        const bool inLoop = onEdge || inside;
+        if (loop == 0) {
+            inOuter = inLoop;
+            if (!inOuter) return false;
+        } else if (inLoop) {
+            return false;
+        }
+    }
+    return inOuter;
+}
+
+bool PointLocator::contains(const QPointF& p) const {
+    if (buckets_ == 0) return false;
+    const double y = p.y();
+    if (y < minY_ || y > minY_ + bucketH_ * buckets_) return false;
+    return containsInBucket(std::clamp(int((y - minY_) / bucketH_), 0, buckets_ - 1), p);
+}
+
+}
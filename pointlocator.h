@@ -0,0 +1,42 @@
+#pragma once
+#include <QVector>
+#include <QPointF>
+#include "inputpolygon.h"
+#include "geometrymodel.h"
+
+namespace Boolean2D {
+
+// Point-in-polygon-with-holes queries against a y-bucketed copy of the loop
+// edges. Answers match a full scan of every loop (on-edge counts as inside,
+// zero-length edges are ignored), but a query only visits the edges whose
+// y-range covers the point.
+class PointLocator {
+public:
+    PointLocator() = default;
+    explicit PointLocator(const InputPolygon& poly, double eps = 1e-9);
+
+    void build(const InputPolygon& poly, double eps = 1e-9);
+    // the same from a topology, outer loop first and holes flagged as such
+    void build(const Geometry::PolygonTopo& topo, double eps = 1e-9);
+    bool contains(const QPointF& p) const;
+    bool isEmpty() const noexcept { return loopCount_ == 0; }
+
+private:
+    template<class LoopEdges>
+    void buildBuckets(int loopCount, double eps, LoopEdges&& loopEdges);
+    bool containsInBucket(int bucket, const QPointF& p) const;
+
+    double eps_      = 1e-9;
+    int    loopCount_ = 0;
+    double minY_     = 0.0;
+    double bucketH_  = 1.0;
+    int    buckets_  = 0;
+    QVector<int>  bucketStart_; // CSR offsets, buckets_ + 1 entries
+    // bucket entries as structure of arrays, per bucket grouped by loop in loop order
+    QVector<double> ax_, ay_; // edge start
+    QVector<double> by_;      // edge end y, for the crossing test
+    QVector<double> dx_, dy_; // end - start
+    QVector<int>    loop_;
+};
+
+}
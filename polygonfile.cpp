@@ -0,0 +1,224 @@
+#include "polygonfile.h"
+
+#include <QSaveFile>
+#include <QSysInfo>
+#include <cstring>
+
+static const char kMagic[8] = { 'P', 'O', 'L', 'Y', 'B', 'I', 'N', '\0' };
+static const quint32 kVersion = 1;
+
+PolygonFileView::~PolygonFileView() {
+    close();
+}
+
+void PolygonFileView::close() {
+    header_ = nullptr;
+    loops_  = nullptr;
+    xs_     = nullptr;
+    ys_     = nullptr;
+    buffer_.clear();
+    if (file_.isOpen()) {
+        file_.close(); // drops the mapping too
+    }
+}
+
+bool PolygonFileView::hasMagic(const char* data, qint64 size) {
+    return size >= qint64(sizeof(kMagic)) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool PolygonFileView::isBinaryFile(const QString& filePath) {
+    QFile file(filePath);
+    char head[sizeof(kMagic)];
+    return file.open(QIODevice::ReadOnly) && file.read(head, sizeof(head)) == qint64(sizeof(head)) &&
+           hasMagic(head, sizeof(head));
+}
+
+bool PolygonFileView::open(const QString& filePath, QString* error) {
+    close();
+    file_.setFileName(filePath);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
+                         ).arg(filePath, file_.errorString());
+        }
+        return false;
+    }
+    const qint64 size = file_.size();
+    const uchar* mapped = size > 0 ? file_.map(0, size) : nullptr;
+    if (mapped) {
+        return attach(reinterpret_cast<const char*>(mapped), size, error);
+    }
+    const QByteArray bytes = file_.readAll();
+    buffer_.resize((bytes.size() + 7) / 8);
+    std::memcpy(buffer_.data(), bytes.constData(), size_t(bytes.size()));
+    return attach(reinterpret_cast<const char*>(buffer_.constData()), bytes.size(), error);
+}
+
+bool PolygonFileView::openMemory(const char* data, qint64 size, QString* error) {
+    close();
+    return attach(data, size, error);
+}
+
+bool PolygonFileView::attach(const char* data, qint64 size, QString* error) {
+    header_ = nullptr;
+    auto fail = [&](const char* what) {
+        if (error) {
+            *error = QStringLiteral("ERROR: BAD BINARY POLYGON FILE. (%1).").arg(QLatin1String(what));
+        }
+        close();
+        return false;
+    };
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+        return fail("big-endian hosts are not supported");
+    }
+    if (!hasMagic(data, size) || size < qint64(sizeof(PolygonFileHeader))) {
+        return fail("missing header");
+    }
+    // the view reads the sections in place, which needs 8-byte alignment
+    if (reinterpret_cast<quintptr>(data) % alignof(double) != 0) {
+        buffer_.resize((size + 7) / 8);
+        std::memcpy(buffer_.data(), data, size_t(size));
+        data = reinterpret_cast<const char*>(buffer_.constData());
+    }
+    const auto* header = reinterpret_cast<const PolygonFileHeader*>(data);
+    if (header->version != kVersion) {
+        return fail("unsupported version");
+    }
+    if (header->reserved != 0) {
+        return fail("reserved field is not 0");
+    }
+    const quint64 tableBytes = quint64(header->loopCount) * sizeof(PolygonFileLoop);
+    const quint64 headerAndTable = sizeof(PolygonFileHeader) + tableBytes;
+    if (header->pointCount > quint64(size) / (2 * sizeof(double)) ||
+        headerAndTable + 2 * sizeof(double) * header->pointCount > quint64(size)) {
+        return fail("truncated");
+    }
+    const auto* loops = reinterpret_cast<const PolygonFileLoop*>(data + sizeof(PolygonFileHeader));
+    for (quint32 i = 0; i < header->loopCount; ++i) {
+        if (loops[i].first > header->pointCount || loops[i].count > header->pointCount - loops[i].first) {
+            return fail("loop out of range");
+        }
+        // one polygon per file: an outer loop first, holes after it
+        if (bool(loops[i].flags & PolygonFileLoop::Hole) != (i > 0)) {
+            return fail("hole flags do not match the loop order");
+        }
+    }
+    header_ = header;
+    loops_  = loops;
+    xs_     = reinterpret_cast<const double*>(data + headerAndTable);
+    ys_     = xs_ + header->pointCount;
+    return true;
+}
+
+void PolygonFileView::toInputPolygon(InputPolygon& out) const {
+    auto loopPoints = [&](int i) {
+        const PolygonFileLoop& L = loops_[i];
+        QVector<QPointF> pts(L.count);
+        for (quint32 k = 0; k < L.count; ++k) {
+            pts[k] = QPointF(xs_[L.first + k], ys_[L.first + k]);
+        }
+        return pts;
+    };
+    QVector<QPointF> outer;
+    QVector<QVector<QPointF>> holes;
+    holes.reserve(qMax(0, loopCount() - 1));
+    for (int i = 0; i < loopCount(); ++i) {
+        if (isHole(i)) holes.push_back(loopPoints(i));
+        else           outer = loopPoints(i); // only loop 0, attach() checks the flags
+    }
+    out.setLoops(outer, holes);
+}
+
+void PolygonFileView::toTopo(Geometry::PolygonTopo& out, double epsClose) const {
+    out.verts.resize(0);
+    out.verts.reserve(pointCount());
+    int count = 0;
+    for (int i = 0; i < loopCount(); ++i) {
+        const PolygonFileLoop& L = loops_[i];
+        qint64 n = L.count;
+        if (n >= 2) {
+            const double dx = xs_[L.first] - xs_[L.first + n - 1];
+            const double dy = ys_[L.first] - ys_[L.first + n - 1];
+            if (dx*dx + dy*dy < epsClose*epsClose) --n;
+        }
+        if (n < 3) continue;
+        if (count == out.loops.size()) out.loops.push_back(Geometry::LoopTopo());
+        Geometry::LoopTopo& loopTopo = out.loops[count++];
+        loopTopo.isHole = isHole(i);
+        loopTopo.loopVertices.resize(0);
+        loopTopo.loopVertices.reserve(n);
+        for (qint64 k = 0; k < n; ++k) {
+            Geometry::Vertex v;
+            v.pos = QPointF(xs_[L.first + k], ys_[L.first + k]);
+            loopTopo.loopVertices.push_back(out.verts.size());
+            out.verts.push_back(v);
+        }
+    }
+    out.loops.resize(count);
+}
+
+bool PolygonFileView::write(const QString& filePath, const InputPolygon& poly, QString* error) {
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+        if (error) {
+            *error = QStringLiteral("ERROR: BAD BINARY POLYGON FILE. (big-endian hosts are not supported).");
+        }
+        return false;
+    }
+    QVector<const QVector<QPointF>*> loops;
+    if (!poly.checkEmpty()) {
+        loops.push_back(&poly.outerLoop());
+        for (const auto& h : poly.holeLoops()) {
+            loops.push_back(&h);
+        }
+    }
+    PolygonFileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version    = kVersion;
+    header.loopCount  = quint32(loops.size());
+    header.pointCount = 0;
+    header.reserved   = 0;
+    QVector<PolygonFileLoop> table;
+    table.reserve(loops.size());
+    for (int i = 0; i < loops.size(); ++i) {
+        PolygonFileLoop L;
+        L.first = header.pointCount;
+        L.count = quint32(loops[i]->size());
+        L.flags = (i > 0) ? PolygonFileLoop::Hole : 0u;
+        table.push_back(L);
+        header.pointCount += L.count;
+    }
+    QVector<double> xs;
+    QVector<double> ys;
+    xs.reserve(header.pointCount);
+    ys.reserve(header.pointCount);
+    for (const auto* loop : loops) {
+        for (const QPointF& p : *loop) {
+            xs.push_back(p.x());
+            ys.push_back(p.y());
+        }
+    }
+
+    QSaveFile saveFile(filePath);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO OPEN FILE %1. (%2)."
+                         ).arg(filePath, saveFile.errorString());
+        }
+        return false;
+    }
+    saveFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    saveFile.write(reinterpret_cast<const char*>(table.constData()), table.size() * qint64(sizeof(PolygonFileLoop)));
+    saveFile.write(reinterpret_cast<const char*>(xs.constData()), xs.size() * qint64(sizeof(double)));
+    saveFile.write(reinterpret_cast<const char*>(ys.constData()), ys.size() * qint64(sizeof(double)));
+    if (!saveFile.commit()) {
+        if (error) {
+            *error = QStringLiteral(
+                         "ERROR: FAIL TO WRITE FILE %1. (%2)."
+                         ).arg(filePath, saveFile.errorString());
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "inputpolygon.h"
+#include "geometrymodel.h"
+
+// Binary polygon container, little-endian, version 1:
+//
+//   header      32 bytes, see PolygonFileHeader
+//   loop table  loopCount x PolygonFileLoop, loop 0 is the outer loop and
+//               every later loop a hole, flagged as such
+//   xs          pointCount doubles
+//   ys          pointCount doubles
+//
+// Every section starts 8-byte aligned, so a mapped file is read in place.
+struct PolygonFileHeader {
+    char    magic[8]; // "POLYBIN\0"
+    quint32 version;
+    quint32 loopCount;
+    quint64 pointCount;
+    quint64 reserved; // 0
+};
+
+struct PolygonFileLoop {
+    quint64 first; // index of the loop's first point in xs / ys
+    quint32 count;
+    quint32 flags; // PolygonFileLoop::Hole
+    enum : quint32 { Hole = 1u };
+};
+
+static_assert(sizeof(PolygonFileHeader) == 32, "binary layout");
+static_assert(sizeof(PolygonFileLoop) == 16, "binary layout");
+
+// Read-only view of a binary polygon file. open() maps the file and checks
+// the header and loop table, hole flags included; the accessors then point
+// into the mapping and stay valid until close() or destruction.
+class PolygonFileView {
+public:
+    PolygonFileView() = default;
+    ~PolygonFileView();
+    PolygonFileView(const PolygonFileView&) = delete;
+    PolygonFileView& operator=(const PolygonFileView&) = delete;
+
+    bool open(const QString& filePath, QString* error = nullptr);
+    // views bytes the caller keeps alive, e.g. a mapping made elsewhere; an
+    // open file is closed first
+    bool openMemory(const char* data, qint64 size, QString* error = nullptr);
+    void close();
+
+    bool isOpen() const noexcept { return header_ != nullptr; }
+    int loopCount() const noexcept { return header_ ? int(header_->loopCount) : 0; }
+    qint64 pointCount() const noexcept { return header_ ? qint64(header_->pointCount) : 0; }
+    const PolygonFileLoop& loop(int i) const { return loops_[i]; }
+    bool isHole(int i) const { return loops_[i].flags & PolygonFileLoop::Hole; }
+    const double* xs() const noexcept { return xs_; }
+    const double* ys() const noexcept { return ys_; }
+
+    // copies the loops out, the view stays open
+    void toInputPolygon(InputPolygon& out) const;
+    // same loops and vertices as Boolean2D::makeTopoFromInput on the loaded
+    // polygon, read straight from the view; out keeps its capacity
+    void toTopo(Geometry::PolygonTopo& out, double epsClose = 1e-9) const;
+
+    static bool hasMagic(const char* data, qint64 size);
+    // reads only the first bytes, false when the file cannot be opened
+    static bool isBinaryFile(const QString& filePath);
+    static bool write(const QString& filePath, const InputPolygon& poly, QString* error = nullptr);
+
+private:
+    // checks and views data, which is the mapping, buffer_ or the caller's
+    bool attach(const char* data, qint64 size, QString* error);
+
+    QFile                  file_;
+    QVector<quint64>       buffer_; // 8-aligned copy when the file cannot be mapped
+    const PolygonFileHeader* header_ = nullptr;
+    const PolygonFileLoop*   loops_  = nullptr;
+    const double*            xs_     = nullptr;
+    const double*            ys_     = nullptr;
+};
@@ -0,0 +1,259 @@
+#include "segmentkernel.h"
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <cmath>
+
+// x86-64 only, where SSE2 is always there and AVX2 is checked at run time
+#if defined(__x86_64__) || defined(_M_X64)
+#define POLYBOOL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define POLYBOOL_TARGET_AVX2
+#else
+#define POLYBOOL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Geometry {
+
+// the lane test of every kernel, in the operand order of intersectSegments
+static inline bool rejectScalar(double ax, double ay, double rx, double ry,
+                                double bx, double by, double sx, double sy, double eps) {
+    const double rxs = rx * sy - ry * sx;
+    if (!(std::fabs(rxs) > eps)) return false;
+    const double ex = bx - ax;
+    const double ey = by - ay;
+    const double t = (ex * sy - ey * sx) / rxs;
+    const double u = (ex * ry - ey * rx) / rxs;
+    return !(t >= -eps && t <= 1.0+eps && u >= -eps && u <= 1.0+eps);
+}
+
+static int filterScalar(const EdgeArrays& A, int i, const EdgeArrays& B, const int* js, int count,
+                        double eps, int* out) {
+    const double ax = A.x0[i], ay = A.y0[i], rx = A.dx[i], ry = A.dy[i];
+    int n = 0;
+    for (int k = 0; k < count; ++k) {
+        const int j = js[k];
+        if (!rejectScalar(ax, ay, rx, ry, B.x0[j], B.y0[j], B.dx[j], B.dy[j], eps)) out[n++] = j;
+    }
+    return n;
+}
+
+static int boxesScalar(const EdgeArrays& A, int i, const EdgeArrays& B, int begin, int end, int* out) {
+    const double minX = A.minX[i], minY = A.minY[i], maxX = A.maxX[i], maxY = A.maxY[i];
+    int n = 0;
+    for (int j = begin; j < end; ++j) {
+        if (B.minX[j] <= maxX && minX <= B.maxX[j] && B.minY[j] <= maxY && minY <= B.maxY[j]) out[n++] = j;
+    }
+    return n;
+}
+
+#ifdef POLYBOOL_X86
+
+static int boxesSSE2(const EdgeArrays& A, int i, const EdgeArrays& B, int begin, int end, int* out) {
+    const __m128d minX = _mm_set1_pd(A.minX[i]);
+    const __m128d minY = _mm_set1_pd(A.minY[i]);
+    const __m128d maxX = _mm_set1_pd(A.maxX[i]);
+    const __m128d maxY = _mm_set1_pd(A.maxY[i]);
+    const double* bMinX = B.minX.constData();
+    const double* bMinY = B.minY.constData();
+    const double* bMaxX = B.maxX.constData();
+    const double* bMaxY = B.maxY.constData();
+    int n = 0;
+    int j = begin;
+    for (; j + 2 <= end; j += 2) {
+        const __m128d hit = _mm_and_pd(
+            _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(bMinX + j), maxX), _mm_cmple_pd(minX, _mm_loadu_pd(bMaxX + j))),
+            _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(bMinY + j), maxY), _mm_cmple_pd(minY, _mm_loadu_pd(bMaxY + j))));
+        const int mask = _mm_movemask_pd(hit);
+        if (mask & 1) out[n++] = j;
+        if (mask & 2) out[n++] = j + 1;
+    }
+    return n + boxesScalar(A, i, B, j, end, out + n);
+}
+
+POLYBOOL_TARGET_AVX2
+static int boxesAVX2(const EdgeArrays& A, int i, const EdgeArrays& B, int begin, int end, int* out) {
+    const __m256d minX = _mm256_set1_pd(A.minX[i]);
+    const __m256d minY = _mm256_set1_pd(A.minY[i]);
+    const __m256d maxX = _mm256_set1_pd(A.maxX[i]);
+    const __m256d maxY = _mm256_set1_pd(A.maxY[i]);
+    const double* bMinX = B.minX.constData();
+    const double* bMinY = B.minY.constData();
+    const double* bMaxX = B.maxX.constData();
+    const double* bMaxY = B.maxY.constData();
+    int n = 0;
+    int j = begin;
+    for (; j + 4 <= end; j += 4) {
+        const __m256d hitX = _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(bMinX + j), maxX, _CMP_LE_OQ),
+                                           _mm256_cmp_pd(minX, _mm256_loadu_pd(bMaxX + j), _CMP_LE_OQ));
+        const __m256d hitY = _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(bMinY + j), maxY, _CMP_LE_OQ),
+                                           _mm256_cmp_pd(minY, _mm256_loadu_pd(bMaxY + j), _CMP_LE_OQ));
+        const int mask = _mm256_movemask_pd(_mm256_and_pd(hitX, hitY));
+        if (mask == 0) continue;
+        for (int l = 0; l < 4; ++l) {
+            if (mask & (1 << l)) out[n++] = j + l;
+        }
+    }
+    return n + boxesScalar(A, i, B, j, end, out + n);
+}
+
+static int filterSSE2(const EdgeArrays& A, int i, const EdgeArrays& B, const int* js, int count,
+                      double eps, int* out) {
+    const __m128d ax = _mm_set1_pd(A.x0[i]);
+    const __m128d ay = _mm_set1_pd(A.y0[i]);
+    const __m128d rx = _mm_set1_pd(A.dx[i]);
+    const __m128d ry = _mm_set1_pd(A.dy[i]);
+    const __m128d vEps = _mm_set1_pd(eps);
+    const __m128d lo   = _mm_set1_pd(-eps);
+    const __m128d hi   = _mm_set1_pd(1.0+eps);
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const double* bx0 = B.x0.constData();
+    const double* by0 = B.y0.constData();
+    const double* bdx = B.dx.constData();
+    const double* bdy = B.dy.constData();
+    int n = 0;
+    int k = 0;
+    for (; k + 2 <= count; k += 2) {
+        const int j0 = js[k], j1 = js[k + 1];
+        const __m128d bx = _mm_set_pd(bx0[j1], bx0[j0]);
+        const __m128d by = _mm_set_pd(by0[j1], by0[j0]);
+        const __m128d sx = _mm_set_pd(bdx[j1], bdx[j0]);
+        const __m128d sy = _mm_set_pd(bdy[j1], bdy[j0]);
+        const __m128d rxs = _mm_sub_pd(_mm_mul_pd(rx, sy), _mm_mul_pd(ry, sx));
+        const __m128d ex  = _mm_sub_pd(bx, ax);
+        const __m128d ey  = _mm_sub_pd(by, ay);
+        const __m128d t = _mm_div_pd(_mm_sub_pd(_mm_mul_pd(ex, sy), _mm_mul_pd(ey, sx)), rxs);
+        const __m128d u = _mm_div_pd(_mm_sub_pd(_mm_mul_pd(ex, ry), _mm_mul_pd(ey, rx)), rxs);
+        const __m128d nonParallel = _mm_cmpgt_pd(_mm_and_pd(rxs, absMask), vEps);
+        const __m128d inRange = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(t, lo), _mm_cmple_pd(t, hi)),
+                                           _mm_and_pd(_mm_cmpge_pd(u, lo), _mm_cmple_pd(u, hi)));
+        const int reject = _mm_movemask_pd(_mm_andnot_pd(inRange, nonParallel));
+        if (!(reject & 1)) out[n++] = j0;
+        if (!(reject & 2)) out[n++] = j1;
+    }
+    return n + filterScalar(A, i, B, js + k, count - k, eps, out + n);
+}
+
+POLYBOOL_TARGET_AVX2
+static int filterAVX2(const EdgeArrays& A, int i, const EdgeArrays& B, const int* js, int count,
+                      double eps, int* out) {
+    const __m256d ax = _mm256_set1_pd(A.x0[i]);
+    const __m256d ay = _mm256_set1_pd(A.y0[i]);
+    const __m256d rx = _mm256_set1_pd(A.dx[i]);
+    const __m256d ry = _mm256_set1_pd(A.dy[i]);
+    const __m256d vEps = _mm256_set1_pd(eps);
+    const __m256d lo   = _mm256_set1_pd(-eps);
+    const __m256d hi   = _mm256_set1_pd(1.0+eps);
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const double* bx0 = B.x0.constData();
+    const double* by0 = B.y0.constData();
+    const double* bdx = B.dx.constData();
+    const double* bdy = B.dy.constData();
+    int n = 0;
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m256d bx, by, sx, sy;
+        const int j0 = js[k];
+        if (js[k + 1] == j0 + 1 && js[k + 2] == j0 + 2 && js[k + 3] == j0 + 3) {
+            // consecutive partners, the common case for brute force and dense rows
+            bx = _mm256_loadu_pd(bx0 + j0);
+            by = _mm256_loadu_pd(by0 + j0);
+            sx = _mm256_loadu_pd(bdx + j0);
+            sy = _mm256_loadu_pd(bdy + j0);
+        } else {
+            // plain lane inserts, hardware gathers are slower on many cores
+            const int j1 = js[k + 1], j2 = js[k + 2], j3 = js[k + 3];
+            bx = _mm256_set_pd(bx0[j3], bx0[j2], bx0[j1], bx0[j0]);
+            by = _mm256_set_pd(by0[j3], by0[j2], by0[j1], by0[j0]);
+            sx = _mm256_set_pd(bdx[j3], bdx[j2], bdx[j1], bdx[j0]);
+            sy = _mm256_set_pd(bdy[j3], bdy[j2], bdy[j1], bdy[j0]);
+        }
+        const __m256d rxs = _mm256_sub_pd(_mm256_mul_pd(rx, sy), _mm256_mul_pd(ry, sx));
+        const __m256d ex  = _mm256_sub_pd(bx, ax);
+        const __m256d ey  = _mm256_sub_pd(by, ay);
+        const __m256d t = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(ex, sy), _mm256_mul_pd(ey, sx)), rxs);
+        const __m256d u = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(ex, ry), _mm256_mul_pd(ey, rx)), rxs);
+        const __m256d nonParallel = _mm256_cmp_pd(_mm256_and_pd(rxs, absMask), vEps, _CMP_GT_OQ);
+        const __m256d inRange = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(t, lo, _CMP_GE_OQ), _mm256_cmp_pd(t, hi, _CMP_LE_OQ)),
+            _mm256_and_pd(_mm256_cmp_pd(u, lo, _CMP_GE_OQ), _mm256_cmp_pd(u, hi, _CMP_LE_OQ)));
+        const int reject = _mm256_movemask_pd(_mm256_andnot_pd(inRange, nonParallel));
+        if (reject == 0xF) continue;
+        for (int l = 0; l < 4; ++l) {
+            if (!(reject & (1 << l))) out[n++] = js[k + l];
+        }
+    }
+    return n + filterScalar(A, i, B, js + k, count - k, eps, out + n);
+}
+
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // POLYBOOL_X86
+
+static SimdLevel detectSimdLevel() {
+    SimdLevel best = SimdLevel::Scalar;
+#ifdef POLYBOOL_X86
+    best = cpuHasAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#endif
+    const QByteArray forced = qgetenv("POLYBOOL_SIMD").toLower();
+    SimdLevel cap = best;
+    if (forced == "scalar")    cap = SimdLevel::Scalar;
+    else if (forced == "sse2") cap = SimdLevel::SSE2;
+    return int(cap) < int(best) ? cap : best;
+}
+
+SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE2:   return "sse2";
+    case SimdLevel::AVX2:   return "avx2";
+    }
+    return "scalar";
+}
+
+int filterBoxRange(const EdgeArrays& A, int i, const EdgeArrays& B, int begin, int end, int* out) {
+    switch (simdLevel()) {
+#ifdef POLYBOOL_X86
+    case SimdLevel::AVX2: return boxesAVX2(A, i, B, begin, end, out);
+    case SimdLevel::SSE2: return boxesSSE2(A, i, B, begin, end, out);
+#endif
+    default:              return boxesScalar(A, i, B, begin, end, out);
+    }
+}
+
+int filterPartners(const EdgeArrays& A, int i, const EdgeArrays& B, const int* js, int count,
+                   double epsGeom, int* out) {
+    // short rows, typical behind an index, are not worth the vector setup
+    if (count < 8) return filterScalar(A, i, B, js, count, epsGeom, out);
+    switch (simdLevel()) {
+#ifdef POLYBOOL_X86
+    case SimdLevel::AVX2: return filterAVX2(A, i, B, js, count, epsGeom, out);
+    case SimdLevel::SSE2: return filterSSE2(A, i, B, js, count, epsGeom, out);
+#endif
+    default:              return filterScalar(A, i, B, js, count, epsGeom, out);
+    }
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "geometrymodel.h"
+
+namespace Geometry {
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Instruction set picked for the filters below: the best the CPU supports, or
+// the one named by POLYBOOL_SIMD (scalar | sse2 | avx2) when it is lower.
+SimdLevel simdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Packed box pre-pass over the B edges begin .. end - 1: copies those whose
+// padded box overlaps the one of A edge i to out, in order, and returns their
+// number. Closed intervals like EdgeIndex, so it drops no pair an index keeps.
+int filterBoxRange(const EdgeArrays& A, int i, const EdgeArrays& B, int begin, int end, int* out);
+
+// Batched pre-test of A edge i against the B edges js[0 .. count). Copies the
+// partners that may intersect to out, in order, and returns their number.
+// A partner is dropped only where intersectSegments takes the non-parallel
+// branch and finds t or u outside [-eps, 1 + eps], i.e. returns None, so
+// running the exact test on the survivors gives the same cuts.
+int filterPartners(const EdgeArrays& A, int i, const EdgeArrays& B, const int* js, int count,
+                   double epsGeom, int* out);
+
+}